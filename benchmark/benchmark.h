@@ -0,0 +1,58 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <vector>
+
+/**
+ * \brief Run \p fn on \p threads threads at the same time.
+ * \details
+ * All threads are started and wait for each other,
+ * before invoking \p fn with their thread index.
+ * \returns The wall clock time between the start signal and the last thread finishing.
+ */
+inline auto run_threads(unsigned int threads, const std::function<void(unsigned int)>& fn)
+-> std::chrono::duration<double> {
+  std::atomic<unsigned int> ready{ 0u };
+  std::atomic<bool> go{ false };
+
+  std::vector<std::thread> workers;
+  workers.reserve(threads);
+  for (unsigned int i = 0; i < threads; ++i) {
+    workers.emplace_back(
+        [&, i]() {
+          ready.fetch_add(1u);
+          while (!go.load()) std::this_thread::yield();
+          fn(i);
+        });
+  }
+
+  while (ready.load() != threads) std::this_thread::yield();
+  const auto t0 = std::chrono::steady_clock::now();
+  go.store(true);
+  for (auto& w : workers) w.join();
+  const auto t1 = std::chrono::steady_clock::now();
+
+  return t1 - t0;
+}
+
+///\brief Thread counts to use for a scaling benchmark: powers of two, up to twice the hardware concurrency.
+inline auto thread_counts() -> std::vector<unsigned int> {
+  const unsigned int hw = std::max(1u, std::thread::hardware_concurrency());
+
+  std::vector<unsigned int> result;
+  for (unsigned int n = 1; n <= 2u * hw; n *= 2u) result.push_back(n);
+  return result;
+}
+
+///\brief Nanoseconds per operation.
+inline auto ns_per_op(std::chrono::duration<double> d, std::size_t ops) -> double {
+  return std::chrono::duration<double, std::nano>(d).count() / double(ops);
+}
+
+#endif /* BENCHMARK_H */
@@ -0,0 +1,31 @@
+#include <instrumentation/counter.h>
+#include <instrumentation/engine.h>
+#include "benchmark.h"
+#include <cstddef>
+#include <cstdio>
+
+using namespace instrumentation;
+
+constexpr std::size_t ops_per_thread = 5'000'000;
+
+auto bench(const counter& c, unsigned int threads) -> double {
+  const auto d = run_threads(
+      threads,
+      [&c](unsigned int) {
+        for (std::size_t i = 0; i < ops_per_thread; ++i) ++c;
+      });
+  return ns_per_op(d, threads * ops_per_thread);
+}
+
+int main() {
+  engine e;
+  const counter plain = counter_vector<>(e, "bench.plain", {}).labels();
+  const counter stripes = counter_vector<>(e, "bench.striped", {}, striped()).labels();
+
+  std::printf("%8s %16s %16s\n", "threads", "plain ns/op", "striped ns/op");
+  for (unsigned int threads : thread_counts()) {
+    const double plain_ns = bench(plain, threads);
+    const double striped_ns = bench(stripes, threads);
+    std::printf("%8u %16.2f %16.2f\n", threads, plain_ns, striped_ns);
+  }
+}
@@ -0,0 +1,39 @@
+#include <instrumentation/counter.h>
+#include <instrumentation/engine.h>
+#include <instrumentation/metric_name.h>
+#include "benchmark.h"
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+using namespace instrumentation;
+
+constexpr std::size_t ops = 2'000'000;
+
+/*
+ * Construct a vector for an existing metric, by name, in a loop.
+ * This is what code does that creates its metric vectors on each request.
+ */
+template<typename Fn>
+auto bench(Fn&& fn) -> double {
+  const auto d = run_threads(
+      1,
+      [&fn](unsigned int) {
+        for (std::size_t i = 0; i < ops; ++i) ++fn().labels();
+      });
+  return ns_per_op(d, ops);
+}
+
+int main() {
+  engine e;
+  // Some other metrics, so the registry isn't trivially small.
+  for (int i = 0; i < 1000; ++i) counter_vector<>(e, "app.component" + std::to_string(i) + ".events", {});
+
+  const std::string name = "http.server.requests";
+  std::printf("%24s %12.2f ns/op\n", "string name",
+      bench([&e, &name]() { return counter_vector<>(e, name, {}); }));
+  std::printf("%24s %12.2f ns/op\n", "string literal",
+      bench([&e]() { return counter_vector<>(e, "http.server.requests", {}); }));
+  std::printf("%24s %12.2f ns/op\n", "_metric literal",
+      bench([&e]() { return counter_vector<>(e, "http.server.requests"_metric, {}); }));
+}
@@ -0,0 +1,459 @@
+#include <instrumentation/prometheus.h>
+#include <instrumentation/collector.h>
+#include <instrumentation/counter.h>
+#include <instrumentation/counter_u64.h>
+#include <instrumentation/gauge.h>
+#include <instrumentation/gauge_i64.h>
+#include <instrumentation/string.h>
+#include <instrumentation/summary.h>
+#include <instrumentation/timing.h>
+#include <instrumentation/engine.h>
+#include <instrumentation/metric_name.h>
+#include <instrumentation/tags.h>
+#include "benchmark.h"
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <ios>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <optional>
+#include <ostream>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+
+using namespace instrumentation;
+using namespace std::chrono_literals;
+
+namespace {
+
+
+/*
+ * The ostream based prometheus writer, as it was before the buffered writer replaced it.
+ * Kept here, to verify that the buffered writer produces identical output.
+ */
+class flag_manager {
+  public:
+  flag_manager() = default;
+
+  flag_manager(std::ios_base& out)
+  : stream_(&out),
+    saved_(stream_->flags())
+  {
+    stream_->setf(std::ios_base::fmtflags(0), std::ios_base::floatfield);
+  }
+
+  flag_manager(const flag_manager&) = delete;
+  flag_manager& operator=(const flag_manager&) = delete;
+
+  flag_manager(flag_manager&& y)
+      noexcept(std::is_nothrow_move_constructible_v<std::ios_base::fmtflags>)
+  : stream_(std::exchange(y.stream_, nullptr)),
+    saved_(std::move_if_noexcept(y.saved_))
+  {}
+
+  flag_manager& operator=(flag_manager&& y)
+      noexcept(std::is_nothrow_move_assignable_v<std::ios_base::fmtflags>) {
+    if (stream_ != nullptr) stream_->flags(saved_);
+
+    stream_ = std::exchange(y.stream_, nullptr);
+    saved_ = std::move(y.saved_);
+    return *this;
+  }
+
+  ~flag_manager() noexcept {
+    if (stream_ != nullptr) stream_->flags(saved_);
+  }
+
+  private:
+  std::ios_base* stream_ = nullptr;
+  std::ios_base::fmtflags saved_;
+};
+
+
+class locale_manager {
+  public:
+  locale_manager() = default;
+
+  locale_manager(std::ios_base& out)
+  : stream_(&out),
+    saved_(stream_->imbue(std::locale::classic()))
+  {}
+
+  locale_manager(const locale_manager&) = delete;
+  locale_manager& operator=(const locale_manager&) = delete;
+
+  locale_manager(locale_manager&& y) noexcept
+  : stream_(std::exchange(y.stream_, nullptr)),
+    saved_(y.saved_)
+  {}
+
+  locale_manager& operator=(locale_manager&& y) noexcept {
+    if (stream_ != nullptr) stream_->imbue(saved_);
+
+    stream_ = std::exchange(y.stream_, nullptr);
+    saved_ = y.saved_;
+    return *this;
+  }
+
+  ~locale_manager() noexcept {
+    if (stream_ != nullptr) stream_->imbue(saved_);
+  }
+
+  private:
+  std::ios_base* stream_ = nullptr;
+  std::locale saved_;
+};
+
+
+class stream_manager {
+  public:
+  stream_manager() = default;
+
+  stream_manager(std::ios_base& out)
+  : loc_(out),
+    fl_(out)
+  {}
+
+  private:
+  locale_manager loc_;
+  flag_manager fl_;
+};
+
+
+class legacy_prom_collector
+: public collector
+{
+  public:
+  legacy_prom_collector(std::ostream& out)
+  : out(out)
+  {}
+
+  void visit_description([[maybe_unused]] const metric_name& name, std::string_view description) override {
+    pending_help.emplace(fix_prom_descr(description));
+  }
+
+  void visit(const metric_name& name, const tags& t, const counter& c) override {
+    write_(name, t, *c, "counter");
+  }
+
+  void visit(const metric_name& name, const tags& t, const counter_u64& c) override {
+    write_(name, t, *c, "counter");
+  }
+
+  void visit(const metric_name& name, const tags& t, const gauge& g) override {
+    write_(name, t, *g, "gauge");
+  }
+
+  void visit(const metric_name& name, const tags& t, const gauge_i64& g) override {
+    write_(name, t, *g, "gauge");
+  }
+
+  void visit(const metric_name& name, const tags& t, const string& s) override {
+    if (t.count("strval") == 0) {
+      tags tag_copy = t;
+      tag_copy.with("strval", *s);
+      write_(name, tag_copy, 1.0, "untyped");
+    }
+  }
+
+  void visit(const metric_name& name, const tags& t, const timing& m) override {
+    const auto h = *m;
+
+    tags tag_copy = t;
+    std::uint64_t cumulative_count = 0;
+    for (const timing::histogram_entry& he : std::get<0>(h)) {
+      std::chrono::duration<double> d = he.le;
+      tag_copy.with("le", d.count());
+
+      cumulative_count += he.bucket_count;
+
+      write_(name, tag_copy, cumulative_count, "histogram");
+    }
+
+    tag_copy.with("le", "+Inf");
+    write_(name, tag_copy, cumulative_count + std::get<1>(h), "histogram");
+  }
+
+  void visit(const metric_name& name, const tags& t, const summary& m) override {
+    const auto [quantiles, count, sum] = *m;
+
+    tags tag_copy = t;
+    for (const summary::quantile_entry& qe : quantiles) {
+      tag_copy.with("quantile", qe.quantile);
+
+      if (count == 0u)
+        write_(name, tag_copy, std::numeric_limits<double>::quiet_NaN(), "summary");
+      else
+        write_(name, tag_copy, std::chrono::duration<double>(qe.value).count(), "summary");
+    }
+
+    write_(name, t, std::chrono::duration<double>(sum).count(), "summary", "_sum");
+    write_(name, t, count, "summary", "_count");
+  }
+
+  private:
+  template<typename T>
+  void write_(const metric_name& name, const tags& t, const T& v, const char* metric_type = "untyped", std::string_view suffix = "") {
+    const auto pm_name = prom_metric_name(name);
+
+    if (pending_help) {
+      if (!pending_help->empty())
+        out << "# HELP " << pm_name << " " << *pending_help << "\n";
+      pending_help.reset();
+      out << "# TYPE " << pm_name << " " << metric_type << "\n";
+    }
+
+    out << pm_name << suffix << "\t";
+    write_tags_(t);
+
+    if constexpr(std::is_floating_point_v<T>) {
+      // For floating point, ensure we handle the edge cases correctly.
+      if (std::isnan(v)) {
+        out << R"("NaN")";
+      } else if (std::isinf(v)) {
+        out << (v < 0 ? R"(-Inf)" : R"(+Inf)");
+      } else {
+        out << v;
+      }
+    } else {
+      out << v;
+    }
+
+    out << "\n";
+  }
+
+  static auto prom_metric_name(const metric_name& name) -> std::string {
+    return fix_prom_name(name.with_separator("_"));
+  }
+
+  void write_tags_(const tags& t) {
+    if (t.empty()) return;
+
+    std::map<std::string, std::string> tmp;
+    for (const auto& e : t) {
+      std::string v_as_str = std::visit(
+          [](const auto& v) -> std::string {
+            if constexpr(std::is_same_v<bool, std::decay_t<decltype(v)>>) {
+              return v ? R"("true")" : R"("false")";
+            } else if constexpr(std::is_same_v<std::int64_t, std::decay_t<decltype(v)>>) {
+              std::ostringstream oss;
+              oss.setf(std::ios_base::dec, std::ios_base::basefield);
+              oss.imbue(std::locale::classic());
+              oss << v;
+              return quote_string(oss.str());
+            } else if constexpr(std::is_same_v<double, std::decay_t<decltype(v)>>) {
+              if (std::isnan(v)) {
+                return R"("NaN")";
+              } else if (std::isinf(v)) {
+                return v < 0 ? R"(-Inf)" : R"(+Inf)";
+              } else {
+                std::ostringstream oss;
+                oss.setf(std::ios_base::fmtflags(0), std::ios_base::floatfield);
+                oss.imbue(std::locale::classic());
+                oss << v;
+                return quote_string(oss.str());
+              }
+            } else {
+              return quote_string(v);
+            }
+          },
+          e.second);
+      tmp.emplace(
+          fix_prom_name(e.first),
+          v_as_str);
+    }
+
+    out << "{";
+    for (const auto& e : tmp) out << e.first << "=" << e.second << ",";
+    out << "}\t";
+  }
+
+  static auto fix_prom_descr(std::string_view s) -> std::string {
+    std::string out;
+    out.reserve(s.size());
+
+    for (const auto& c : s) {
+      switch (c) {
+        default:
+          out.push_back(c);
+          break;
+        case '\\':
+          out.append(R"(\\)");
+          break;
+        case '\n':
+          out.append(R"(\n)");
+          break;
+      }
+    }
+
+    return out;
+  }
+
+  static auto fix_prom_name(std::string_view s) -> std::string {
+    static const auto bad_start_characters = std::regex("[^a-zA-Z_:]");
+    static const auto bad_tail_characters = std::regex("[^a-zA-Z0-9_:]");
+
+    std::string out;
+    out.reserve(s.size());
+
+    if (!s.empty()) {
+      std::regex_replace(
+          std::back_inserter(out),
+          s.begin(), s.begin() + 1u,
+          bad_start_characters,
+          "_");
+      std::regex_replace(
+          std::back_inserter(out),
+          s.begin() + 1u, s.end(),
+          bad_tail_characters,
+          "_");
+    }
+
+    return out;
+  }
+
+  static auto quote_string(std::string_view s) -> std::string {
+    std::string out;
+    out.reserve(s.size() + 2u);
+
+    out.append(1, '"');
+
+    for (char c : s) {
+      switch (c) {
+      default:
+        out.push_back(c);
+        break;
+      case '\n':
+        out.append(R"(\n)");
+        break;
+      case '\\':
+        out.append(R"(\\)");
+        break;
+      case '"':
+        out.append(R"(\")");
+        break;
+      }
+    }
+
+    out.append(1, '"');
+    return out;
+  }
+
+  std::ostream& out;
+  std::optional<std::string> pending_help;
+};
+
+
+auto legacy_collect_prometheus(const engine& e) -> std::string {
+  std::ostringstream oss;
+  stream_manager sm{ oss };
+  legacy_prom_collector pc(oss);
+  e.collect(pc);
+  return std::move(oss).str();
+}
+
+
+} /* namespace <unnamed> */
+
+constexpr int scrapes = 5;
+
+template<typename Fn>
+auto bench(Fn&& fn) -> double {
+  const auto d = run_threads(
+      1,
+      [&fn](unsigned int) {
+        for (int i = 0; i < scrapes; ++i) fn();
+      });
+  return std::chrono::duration<double, std::milli>(d).count() / scrapes;
+}
+
+int main() {
+  engine e;
+
+  // 200k counter series, with two labels.
+  counter_vector<std::string, int> requests(e, "http.requests", { "path", "status" }, "Number of requests");
+  for (int i = 0; i < 100'000; ++i) {
+    requests.labels("/api/v1/resource/" + std::to_string(i), 200) += i;
+    requests.labels("/api/v1/resource/" + std::to_string(i), 500) += 0.5 * i;
+  }
+
+  // 10k histogram series, with the default buckets.
+  timing_vector<std::string> latency(e, "http.latency", { "path" }, "Request latency");
+  for (int i = 0; i < 10'000; ++i) latency.labels("/api/v2/resource/" + std::to_string(i)) << std::chrono::microseconds(37 * i);
+
+  // 1k summary series.
+  summary_vector<int> sizes(e, "http.response.size", { "shard" }, "Response size");
+  for (int i = 0; i < 1'000; ++i) sizes.labels(i) << std::chrono::milliseconds(i);
+
+  // Some gauges and strings.
+  gauge_i64_vector<int> queue(e, "queue.depth", { "queue" });
+  string_vector<> version(e, "build.version", {});
+  for (int i = 0; i < 1'000; ++i) queue.labels(i) = -i;
+  version.labels() = "2.0 \"beta\"";
+
+  const std::string legacy_output = legacy_collect_prometheus(e);
+  const std::string output = collect_prometheus(e);
+  if (legacy_output != output) {
+    std::fprintf(stderr, "output differs from the previous implementation\n");
+    return 1;
+  }
+  std::printf("output identical: %zu bytes\n", output.size());
+
+  std::string reused;
+  const double legacy_ms = bench([&e]() { legacy_collect_prometheus(e); });
+  const double string_ms = bench([&e]() { collect_prometheus(e); });
+  const double reused_ms = bench(
+      [&e, &reused]() {
+        reused.clear();
+        collect_prometheus(reused, e);
+      });
+  std::string reused_protobuf;
+  const double protobuf_ms = bench(
+      [&e, &reused_protobuf]() {
+        reused_protobuf.clear();
+        collect_prometheus_protobuf(reused_protobuf, e);
+      });
+  std::string reused_gzip;
+  const double gzip_ms = !prometheus_gzip_supported() ? 0.0 : bench(
+      [&e, &reused_gzip]() {
+        reused_gzip.clear();
+        collect_prometheus_gzip(reused_gzip, e);
+      });
+  std::ostringstream oss;
+  const double stream_ms = bench(
+      [&e, &oss]() {
+        oss.str(std::string());
+        collect_prometheus(oss, e);
+      });
+
+  std::printf("%28s %10.2f ms/scrape\n", "ostream writer (legacy)", legacy_ms);
+  std::printf("%28s %10.2f ms/scrape\n", "buffered, to new string", string_ms);
+  std::printf("%28s %10.2f ms/scrape\n", "buffered, to reused string", reused_ms);
+  std::printf("%28s %10.2f ms/scrape\n", "buffered, to ostream", stream_ms);
+  std::printf("%28s %10.2f ms/scrape (%zu bytes)\n", "protobuf, to reused string", protobuf_ms, reused_protobuf.size());
+  if (prometheus_gzip_supported())
+    std::printf("%28s %10.2f ms/scrape (%zu bytes)\n", "gzip, to reused string", gzip_ms, reused_gzip.size());
+
+  // Parallel collection splits work by metric group.
+  if (collect_prometheus_parallel(e, 4) != output) {
+    std::fprintf(stderr, "parallel output differs from serial output\n");
+    return 1;
+  }
+  for (unsigned int threads : thread_counts()) {
+    std::string reused_parallel;
+    const double parallel_ms = bench(
+        [&e, &reused_parallel, threads]() {
+          reused_parallel.clear();
+          collect_prometheus_parallel(reused_parallel, e, threads);
+        });
+    std::printf("%20s %2u thr %10.2f ms/scrape\n", "parallel,", threads, parallel_ms);
+  }
+}
@@ -0,0 +1,61 @@
+#include <instrumentation/counter_u64.h>
+#include <instrumentation/engine.h>
+#include <instrumentation/interned_string.h>
+#include "benchmark.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace instrumentation;
+
+constexpr std::size_t ops = 5'000'000;
+
+/*
+ * Look up existing series in a random order,
+ * so that the table can't stay in cache for small steps.
+ */
+template<typename Vector, typename Label>
+auto bench(Vector& v, const std::vector<Label>& labels, const std::vector<std::size_t>& order) -> double {
+  const auto d = run_threads(
+      1,
+      [&v, &labels, &order](unsigned int) {
+        for (std::size_t i = 0; i < ops; ++i) ++v.labels(labels[order[i % order.size()]]);
+      });
+  return ns_per_op(d, ops);
+}
+
+int main() {
+  std::mt19937_64 rng;
+
+  for (const std::size_t series : { std::size_t(1'000), std::size_t(100'000), std::size_t(1'000'000) }) {
+    std::vector<std::uint64_t> int_labels;
+    std::vector<std::string> string_labels;
+    std::vector<interned_string> interned_labels;
+    for (std::size_t i = 0; i < series; ++i) {
+      int_labels.push_back(i);
+      string_labels.push_back("/api/v1/resource/" + std::to_string(i));
+      interned_labels.push_back(string_labels.back());
+    }
+
+    std::uniform_int_distribution<std::size_t> pick(0, series - 1u);
+    std::vector<std::size_t> order;
+    for (std::size_t i = 0; i < 65536; ++i) order.push_back(pick(rng));
+
+    engine e;
+    counter_u64_vector<std::uint64_t> int_vector(e, "bench.int", { "id" });
+    counter_u64_vector<std::string> string_vector(e, "bench.string", { "path" });
+    counter_u64_vector<interned_string> interned_vector(e, "bench.interned", { "path" });
+    for (std::size_t i = 0; i < series; ++i) {
+      int_vector.labels(int_labels[i]);
+      string_vector.labels(string_labels[i]);
+      interned_vector.labels(interned_labels[i]);
+    }
+
+    std::printf("%8zu series %16s %12.2f ns/op\n", series, "integer label", bench(int_vector, int_labels, order));
+    std::printf("%8zu series %16s %12.2f ns/op\n", series, "string label", bench(string_vector, string_labels, order));
+    std::printf("%8zu series %16s %12.2f ns/op\n", series, "interned label", bench(interned_vector, interned_labels, order));
+  }
+}
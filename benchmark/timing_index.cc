@@ -0,0 +1,42 @@
+#include <instrumentation/timing.h>
+#include <instrumentation/engine.h>
+#include "benchmark.h"
+#include <chrono>
+#include <cstddef>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace instrumentation;
+using namespace std::chrono_literals;
+
+constexpr std::size_t ops = 20'000'000;
+
+/*
+ * Record durations with a log-uniform distribution between 100us and 10s,
+ * so that the bucket search can't be predicted.
+ */
+auto bench(const timing& t, const std::vector<timing::duration>& samples) -> double {
+  const auto d = run_threads(
+      1,
+      [&t, &samples](unsigned int) {
+        for (std::size_t i = 0; i < ops; ++i) t << samples[i % samples.size()];
+      });
+  return ns_per_op(d, ops);
+}
+
+int main() {
+  std::mt19937_64 rng;
+  std::uniform_real_distribution<double> exponent(-4.0, 1.0);
+  std::vector<timing::duration> samples;
+  for (int i = 0; i < 4096; ++i)
+    samples.push_back(std::chrono::duration_cast<timing::duration>(std::chrono::duration<double>(std::pow(10.0, exponent(rng)))));
+
+  engine e;
+  const timing searched = timing_vector<>(e, "bench.searched", {}, timing_vector<>::default_buckets(), "").labels();
+  const timing log_linear = timing_vector<>(e, "bench.log_linear", {}, log_linear_buckets{ 100us, 100s, 3 }, "").labels();
+
+  std::printf("%24s %12.2f ns/op\n", "default buckets", bench(searched, samples));
+  std::printf("%24s %12.2f ns/op\n", "log-linear buckets", bench(log_linear, samples));
+}
@@ -0,0 +1,43 @@
+#include <instrumentation/timing.h>
+#include <instrumentation/engine.h>
+#include "benchmark.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+
+using namespace instrumentation;
+
+constexpr std::size_t ops_per_thread = 5'000'000;
+
+/*
+ * With spread set, each thread records a duration in the 1ms..9ms range,
+ * a different one per thread, so that the threads hit neighbouring buckets.
+ * Otherwise all threads record into the same bucket.
+ */
+auto bench(const timing& t, unsigned int threads, bool spread) -> double {
+  const auto d = run_threads(
+      threads,
+      [&t, spread](unsigned int thread_idx) {
+        const auto d = std::chrono::milliseconds(spread ? 1 + thread_idx % 9u : 5u);
+        for (std::size_t i = 0; i < ops_per_thread; ++i) t << d;
+      });
+  return ns_per_op(d, threads * ops_per_thread);
+}
+
+int main() {
+  engine e;
+  const timing compact = timing_vector<>(e, "bench.compact", {}, timing_vector<>::default_buckets(), timing_layout::compact, "").labels();
+  const timing padded = timing_vector<>(e, "bench.padded", {}, timing_vector<>::default_buckets(), timing_layout::padded, "").labels();
+  const timing sharded = timing_vector<>(e, "bench.sharded", {}, timing_vector<>::default_buckets(), timing_layout::sharded, "").labels();
+
+  for (bool spread : { true, false }) {
+    std::printf("%s\n", spread ? "neighbouring buckets" : "same bucket");
+    std::printf("%8s %16s %16s %16s\n", "threads", "compact ns/op", "padded ns/op", "sharded ns/op");
+    for (unsigned int threads : thread_counts()) {
+      const double compact_ns = bench(compact, threads, spread);
+      const double padded_ns = bench(padded, threads, spread);
+      const double sharded_ns = bench(sharded, threads, spread);
+      std::printf("%8u %16.2f %16.2f %16.2f\n", threads, compact_ns, padded_ns, sharded_ns);
+    }
+  }
+}
@@ -0,0 +1,184 @@
+#ifndef INSTRUMENTATION_BATCH_H
+#define INSTRUMENTATION_BATCH_H
+
+#include <instrumentation/fwd.h>
+#include <instrumentation/counter.h>
+#include <instrumentation/counter_u64.h>
+#include <instrumentation/timing.h>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace instrumentation {
+
+
+/**
+ * \brief Local accumulator for a counter.
+ * \details
+ * Increments are added to a plain, non-atomic value.
+ * The accumulated value is published to the counter
+ * when flush() is called, or when the batch is destroyed.
+ *
+ * A batch must only be used from a single thread.
+ *
+ * \tparam Counter The counter type, either counter or counter_u64.
+ */
+template<typename Counter>
+class basic_counter_batch {
+  public:
+  using value_type = std::decay_t<decltype(*std::declval<const Counter&>())>;
+
+  basic_counter_batch() noexcept = default;
+
+  explicit basic_counter_batch(Counter c) noexcept
+  : c_(std::move(c))
+  {}
+
+  ///\brief Take over the counter and the accumulated value of \p y, leaving \p y empty.
+  basic_counter_batch(basic_counter_batch&& y) noexcept
+  : c_(std::move(y.c_)),
+    pending_(std::exchange(y.pending_, value_type(0)))
+  {}
+
+  basic_counter_batch(const basic_counter_batch&) = delete;
+
+  ///\brief Flush this batch, then take over the counter and the accumulated value of \p y, leaving \p y empty.
+  basic_counter_batch& operator=(basic_counter_batch&& y) noexcept {
+    if (this != &y) {
+      flush();
+      c_ = std::move(y.c_);
+      pending_ = std::exchange(y.pending_, value_type(0));
+    }
+    return *this;
+  }
+
+  basic_counter_batch& operator=(const basic_counter_batch&) = delete;
+
+  ~basic_counter_batch() noexcept {
+    flush();
+  }
+
+  void operator++() noexcept { ++pending_; }
+  void operator++(int) noexcept { ++pending_; }
+  void operator+=(value_type d) noexcept { pending_ += d; }
+
+  ///\brief Publish the accumulated value to the counter.
+  void flush() noexcept {
+    if (pending_ != value_type(0)) c_ += std::exchange(pending_, value_type(0));
+  }
+
+  explicit operator bool() const noexcept { return bool(c_); }
+  auto operator!() const noexcept -> bool { return !c_; }
+
+  private:
+  Counter c_;
+  value_type pending_ = value_type(0);
+};
+
+using counter_batch = basic_counter_batch<counter>;
+using counter_u64_batch = basic_counter_batch<counter_u64>;
+
+
+/**
+ * \brief Local accumulator for a timing.
+ * \details
+ * Durations are recorded in a plain, non-atomic local histogram.
+ * The local histogram is merged into the timing in a single pass,
+ * when flush() is called, or when the batch is destroyed.
+ *
+ * A batch must only be used from a single thread.
+ *
+ * Like timing, a timing_batch can be used with time_track.
+ */
+class timing_batch {
+  public:
+  using clock_type = timing::clock_type;
+  using duration = timing::duration;
+
+  timing_batch() noexcept = default;
+  explicit timing_batch(timing t);
+
+  ///\brief Take over the timing and the local histogram of \p y, leaving \p y empty.
+  timing_batch(timing_batch&& y) noexcept;
+  timing_batch(const timing_batch&) = delete;
+  ///\brief Flush this batch, then take over the timing and the local histogram of \p y, leaving \p y empty.
+  timing_batch& operator=(timing_batch&& y) noexcept;
+  timing_batch& operator=(const timing_batch&) = delete;
+
+  ~timing_batch() noexcept;
+
+  auto operator<<(duration d) noexcept -> timing_batch&;
+
+  ///\brief Merge the local histogram into the timing.
+  void flush() noexcept;
+
+  explicit operator bool() const noexcept;
+  auto operator!() const noexcept -> bool;
+
+  private:
+  timing t_;
+  std::vector<std::uint64_t> counts_;
+  bool dirty_ = false;
+};
+
+
+inline timing_batch::timing_batch(timing t)
+: t_(std::move(t))
+{
+  if (t_.impl_) counts_.resize(t_.impl_->bucket_count());
+}
+
+inline timing_batch::timing_batch(timing_batch&& y) noexcept
+: t_(std::move(y.t_)),
+  counts_(std::move(y.counts_)),
+  dirty_(std::exchange(y.dirty_, false))
+{
+  y.counts_.clear();
+}
+
+inline timing_batch& timing_batch::operator=(timing_batch&& y) noexcept {
+  if (this != &y) {
+    flush();
+    t_ = std::move(y.t_);
+    counts_ = std::move(y.counts_);
+    dirty_ = std::exchange(y.dirty_, false);
+    y.counts_.clear();
+  }
+  return *this;
+}
+
+inline timing_batch::~timing_batch() noexcept {
+  flush();
+}
+
+inline auto timing_batch::operator<<(duration d) noexcept -> timing_batch& {
+  if (t_.impl_) {
+    ++counts_[t_.impl_->bucket_index(d)];
+    dirty_ = true;
+  }
+  return *this;
+}
+
+inline void timing_batch::flush() noexcept {
+  if (!dirty_) return;
+
+  for (std::size_t idx = 0; idx < counts_.size(); ++idx) {
+    if (counts_[idx] != 0u)
+      t_.impl_->inc_bucket(idx, std::exchange(counts_[idx], 0u));
+  }
+  dirty_ = false;
+}
+
+inline timing_batch::operator bool() const noexcept {
+  return bool(t_);
+}
+
+inline auto timing_batch::operator!() const noexcept -> bool {
+  return !t_;
+}
+
+
+} /* namespace instrumentation */
+
+#endif /* INSTRUMENTATION_BATCH_H */
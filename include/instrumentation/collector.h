@@ -16,9 +16,12 @@ class instrumentation_export_ collector {
 
   virtual void visit_description(const metric_name& name, std::string_view description);
   virtual void visit(const metric_name& name, const tags& tags, const counter& v) = 0;
+  virtual void visit(const metric_name& name, const tags& tags, const counter_u64& v) = 0;
   virtual void visit(const metric_name& name, const tags& tags, const gauge& v) = 0;
+  virtual void visit(const metric_name& name, const tags& tags, const gauge_i64& v) = 0;
   virtual void visit(const metric_name& name, const tags& tags, const string& v) = 0;
   virtual void visit(const metric_name& name, const tags& tags, const timing& v) = 0;
+  virtual void visit(const metric_name& name, const tags& tags, const summary& v) = 0;
 };
 
 
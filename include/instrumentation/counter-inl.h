@@ -46,11 +46,47 @@ counter_vector<LabelTypes...>::counter_vector(
     engine& e,
     metric_name name,
     std::array<std::string, sizeof...(LabelTypes)> labels,
+    std::string description)
+: counter_vector(e, std::move(name), std::move(labels), striped(1), std::move(description))
+{}
+
+template<typename... LabelTypes>
+counter_vector<LabelTypes...>::counter_vector(
+    std::string_view name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    std::string description)
+: counter_vector(metric_name(name), std::move(labels), std::move(description))
+{}
+
+template<typename... LabelTypes>
+counter_vector<LabelTypes...>::counter_vector(
+    engine& e,
+    std::string_view name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    std::string description)
+: counter_vector(e, metric_name(name), std::move(labels), std::move(description))
+{}
+
+template<typename... LabelTypes>
+counter_vector<LabelTypes...>::counter_vector(
+    metric_name name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    striped stripes,
+    std::string description)
+: counter_vector(engine::global(), std::move(name), std::move(labels), std::move(stripes), std::move(description))
+{}
+
+template<typename... LabelTypes>
+counter_vector<LabelTypes...>::counter_vector(
+    engine& e,
+    metric_name name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    striped stripes,
     std::string description) {
   const auto raw_metric = e.get_metric(
       std::move(name),
-      [&labels, &description]() {
-        return group_type::make(std::move(labels), std::move(description));
+      [&labels, &description, &stripes]() {
+        return group_type::make(std::move(labels), std::move(description), std::move(stripes));
       });
   // We silently allow for a null impl if the metric doesn't match type.
   impl_ = std::dynamic_pointer_cast<group_type>(raw_metric);
@@ -60,8 +96,9 @@ template<typename... LabelTypes>
 counter_vector<LabelTypes...>::counter_vector(
     std::string_view name,
     std::array<std::string, sizeof...(LabelTypes)> labels,
+    striped stripes,
     std::string description)
-: counter_vector(metric_name(name), std::move(labels), std::move(description))
+: counter_vector(metric_name(name), std::move(labels), std::move(stripes), std::move(description))
 {}
 
 template<typename... LabelTypes>
@@ -69,19 +106,42 @@ counter_vector<LabelTypes...>::counter_vector(
     engine& e,
     std::string_view name,
     std::array<std::string, sizeof...(LabelTypes)> labels,
+    striped stripes,
     std::string description)
-: counter_vector(e, metric_name(name), std::move(labels), std::move(description))
+: counter_vector(e, metric_name(name), std::move(labels), std::move(stripes), std::move(description))
 {}
 
 template<typename... LabelTypes>
-auto counter_vector<LabelTypes...>::labels(const LabelTypes&... values) const -> counter {
+auto counter_vector<LabelTypes...>::labels(detail::label_arg_t<LabelTypes>... values) const -> counter {
   counter result;
   if (impl_ == nullptr) return result;
 
-  result.impl_ = impl_->get(std::make_tuple(values...));
+  result.impl_ = impl_->get(values...);
   return result;
 }
 
+template<typename... LabelTypes>
+void counter_vector<LabelTypes...>::expire(expiry policy) const {
+  if (impl_ != nullptr) impl_->expire(std::move(policy));
+}
+
+template<typename... LabelTypes>
+auto counter_vector<LabelTypes...>::expired() const noexcept -> std::uint64_t {
+  if (impl_ == nullptr) return 0;
+  return impl_->expired();
+}
+
+template<typename... LabelTypes>
+void counter_vector<LabelTypes...>::limit_series(std::size_t n) const noexcept {
+  if (impl_ != nullptr) impl_->limit_series(n);
+}
+
+template<typename... LabelTypes>
+auto counter_vector<LabelTypes...>::dropped() const noexcept -> std::uint64_t {
+  if (impl_ == nullptr) return 0;
+  return impl_->dropped();
+}
+
 template<typename... LabelTypes>
 counter_vector<LabelTypes...>::operator bool() const noexcept {
   return impl_ != nullptr;
@@ -98,15 +158,30 @@ auto counter_vector<LabelTypes...>::operator!() const noexcept -> bool {
 namespace instrumentation::detail {
 
 
+inline counter_impl::counter_impl(striped stripes) {
+  if (stripes.size() > 1u) {
+    cells_ = std::make_unique<cell[]>(stripes.size());
+    cells_mask_ = stripes.size() - 1u;
+  }
+}
+
 inline void counter_impl::inc(double d) noexcept {
-  double expect = v_.load(std::memory_order_relaxed);
-  while (!v_.compare_exchange_weak(expect, expect + d, std::memory_order_relaxed, std::memory_order_relaxed)) {
+  std::atomic<double>& v = (cells_ == nullptr ? v_ : cells_[stripe_index() & cells_mask_].v);
+
+  double expect = v.load(std::memory_order_relaxed);
+  while (!v.compare_exchange_weak(expect, expect + d, std::memory_order_relaxed, std::memory_order_relaxed)) {
     // SKIP
   }
+  generation_.touch();
 }
 
 inline auto counter_impl::get() const noexcept -> double {
-  return v_.load(std::memory_order_relaxed);
+  double sum = v_.load(std::memory_order_relaxed);
+  if (cells_ != nullptr) {
+    for (std::size_t i = 0; i <= cells_mask_; ++i)
+      sum += cells_[i].v.load(std::memory_order_relaxed);
+  }
+  return sum;
 }
 
 inline void counter_impl::collect(const metric_name& name, const tags& tags, collector& c) {
@@ -115,6 +190,10 @@ inline void counter_impl::collect(const metric_name& name, const tags& tags, col
   return c.visit(name, tags, tmp);
 }
 
+inline auto counter_impl::generation() const noexcept -> const generation_marker& {
+  return generation_;
+}
+
 
 } /* namespace instrumentation::detail */
 
@@ -2,9 +2,14 @@
 #define INSTRUMENTATION_COUNTER_H
 
 #include <instrumentation/fwd.h>
+#include <instrumentation/expiry.h>
+#include <instrumentation/striped.h>
 #include <instrumentation/detail/metric_group.h>
+#include <instrumentation/detail/stripe.h>
 #include <array>
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <memory>
 
@@ -14,13 +19,27 @@ namespace instrumentation::detail {
 class counter_impl
 : public std::enable_shared_from_this<counter_impl>
 {
+  private:
+  struct alignas(cache_line_size) cell {
+    std::atomic<double> v{ 0.0 };
+  };
+
   public:
+  counter_impl() noexcept = default;
+  explicit counter_impl(striped stripes);
+
   void inc(double d = 1.0) noexcept;
   auto get() const noexcept -> double;
   void collect(const metric_name& name, const tags& tags, collector& c);
+  ///\brief Generation in which this metric was last modified.
+  auto generation() const noexcept -> const generation_marker&;
 
   private:
   std::atomic<double> v_{ 0.0 };
+  ///\brief Striped cells, or null if the counter is not striped.
+  std::unique_ptr<cell[]> cells_;
+  std::size_t cells_mask_ = 0;
+  generation_marker generation_;
 };
 
 
@@ -60,8 +79,21 @@ class counter_vector {
   counter_vector(engine& e, metric_name name, std::array<std::string, sizeof...(LabelTypes)> labels, std::string description = "");
   counter_vector(std::string_view name, std::array<std::string, sizeof...(LabelTypes)> labels, std::string description = "");
   counter_vector(engine& e, std::string_view name, std::array<std::string, sizeof...(LabelTypes)> labels, std::string description = "");
-
-  auto labels(const LabelTypes&... values) const -> counter;
+  counter_vector(metric_name name, std::array<std::string, sizeof...(LabelTypes)> labels, striped stripes, std::string description = "");
+  counter_vector(engine& e, metric_name name, std::array<std::string, sizeof...(LabelTypes)> labels, striped stripes, std::string description = "");
+  counter_vector(std::string_view name, std::array<std::string, sizeof...(LabelTypes)> labels, striped stripes, std::string description = "");
+  counter_vector(engine& e, std::string_view name, std::array<std::string, sizeof...(LabelTypes)> labels, striped stripes, std::string description = "");
+
+  auto labels(detail::label_arg_t<LabelTypes>... values) const -> counter;
+
+  ///\brief Set the policy for removing idle series.
+  void expire(expiry policy) const;
+  ///\brief Number of series removed by the expiry policy.
+  auto expired() const noexcept -> std::uint64_t;
+  ///\brief Limit the number of series, directing further label sets to a shared overflow series.
+  void limit_series(std::size_t n) const noexcept;
+  ///\brief Number of lookups that were directed to the overflow series.
+  auto dropped() const noexcept -> std::uint64_t;
 
   explicit operator bool() const noexcept;
   auto operator!() const noexcept -> bool;
@@ -0,0 +1,99 @@
+#ifndef INSTRUMENTATION_COUNTER_U64_H
+#define INSTRUMENTATION_COUNTER_U64_H
+
+#include <instrumentation/fwd.h>
+#include <instrumentation/expiry.h>
+#include <instrumentation/detail/metric_group.h>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <memory>
+
+namespace instrumentation::detail {
+
+
+class counter_u64_impl
+: public std::enable_shared_from_this<counter_u64_impl>
+{
+  public:
+  void inc(std::uint64_t d = 1u) noexcept;
+  auto get() const noexcept -> std::uint64_t;
+  void collect(const metric_name& name, const tags& tags, collector& c);
+  ///\brief Generation in which this metric was last modified.
+  auto generation() const noexcept -> const generation_marker&;
+
+  private:
+  std::atomic<std::uint64_t> v_{ 0u };
+  generation_marker generation_;
+};
+
+
+} /* namespace instrumentation::detail */
+
+namespace instrumentation {
+
+
+/**
+ * \brief Integer valued counter.
+ * \details
+ * Like counter, but counts whole events.
+ * Increments are a single atomic add and the value is exact over the full 64-bit range.
+ */
+class counter_u64 {
+  friend detail::counter_u64_impl;
+  template<typename... LabelTypes> friend class counter_u64_vector;
+
+  public:
+  counter_u64() noexcept = default;
+
+  void operator++() const noexcept;
+  void operator++(int) const noexcept;
+  void operator+=(std::uint64_t d) const noexcept;
+
+  explicit operator bool() const noexcept;
+  auto operator!() const noexcept -> bool;
+  auto operator*() const -> std::uint64_t;
+
+  private:
+  std::shared_ptr<detail::counter_u64_impl> impl_;
+};
+
+
+template<typename... LabelTypes>
+class counter_u64_vector {
+  private:
+  using group_type = detail::metric_group<detail::counter_u64_impl, LabelTypes...>;
+
+  public:
+  counter_u64_vector() noexcept = default;
+  counter_u64_vector(metric_name name, std::array<std::string, sizeof...(LabelTypes)> labels, std::string description = "");
+  counter_u64_vector(engine& e, metric_name name, std::array<std::string, sizeof...(LabelTypes)> labels, std::string description = "");
+  counter_u64_vector(std::string_view name, std::array<std::string, sizeof...(LabelTypes)> labels, std::string description = "");
+  counter_u64_vector(engine& e, std::string_view name, std::array<std::string, sizeof...(LabelTypes)> labels, std::string description = "");
+
+  auto labels(detail::label_arg_t<LabelTypes>... values) const -> counter_u64;
+
+  ///\brief Set the policy for removing idle series.
+  void expire(expiry policy) const;
+  ///\brief Number of series removed by the expiry policy.
+  auto expired() const noexcept -> std::uint64_t;
+  ///\brief Limit the number of series, directing further label sets to a shared overflow series.
+  void limit_series(std::size_t n) const noexcept;
+  ///\brief Number of lookups that were directed to the overflow series.
+  auto dropped() const noexcept -> std::uint64_t;
+
+  explicit operator bool() const noexcept;
+  auto operator!() const noexcept -> bool;
+
+  private:
+  std::shared_ptr<group_type> impl_;
+};
+
+
+} /* namespace instrumentation */
+
+#include "counter_u64-inl.h"
+
+#endif /* INSTRUMENTATION_COUNTER_U64_H */
@@ -12,12 +12,26 @@
 #   define instrumentation_export_  __declspec(dllimport)
 #   define instrumentation_local_   /* nothing */
 # endif
+# ifdef instrumentation_http_EXPORTS
+#   define instrumentation_http_export_  __declspec(dllexport)
+# else
+#   define instrumentation_http_export_  __declspec(dllimport)
+# endif
+# ifdef instrumentation_statsd_EXPORTS
+#   define instrumentation_statsd_export_  __declspec(dllexport)
+# else
+#   define instrumentation_statsd_export_  __declspec(dllimport)
+# endif
 #elif defined(__GNUC__) || defined(__clang__)
 # define instrumentation_export_    __attribute__ ((visibility ("default")))
 # define instrumentation_local_     __attribute__ ((visibility ("hidden")))
+# define instrumentation_http_export_  __attribute__ ((visibility ("default")))
+# define instrumentation_statsd_export_  __attribute__ ((visibility ("default")))
 #else
 # define instrumentation_export_    /* nothing */
 # define instrumentation_local_     /* nothing */
+# define instrumentation_http_export_  /* nothing */
+# define instrumentation_statsd_export_  /* nothing */
 #endif
 
 #endif /* INSTRUMENTATION_DETAIL_EXPORT__H */
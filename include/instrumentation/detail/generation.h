@@ -0,0 +1,59 @@
+#ifndef INSTRUMENTATION_DETAIL_GENERATION_H
+#define INSTRUMENTATION_DETAIL_GENERATION_H
+
+#include <instrumentation/detail/export_.h>
+#include <atomic>
+#include <cstdint>
+
+namespace instrumentation::detail {
+
+
+/**
+ * \brief The current generation.
+ * \details
+ * The generation is advanced by engine::collect_changed.
+ * Series record the generation in which they were last modified.
+ */
+instrumentation_export_
+extern std::atomic<std::uint64_t> current_generation;
+
+/**
+ * \brief Records the generation in which a series was last modified.
+ * \details
+ * Touching the marker only writes if the generation advanced since the previous touch,
+ * so that frequent updates don't keep writing the same cache line.
+ */
+class generation_marker {
+  public:
+  generation_marker() noexcept;
+
+  ///\brief Mark the series as modified in the current generation.
+  void touch() noexcept;
+  ///\brief Test if the series was modified in generation \p since, or later.
+  auto changed_since(std::uint64_t since) const noexcept -> bool;
+
+  private:
+  std::atomic<std::uint64_t> gen_;
+};
+
+
+inline generation_marker::generation_marker() noexcept
+: gen_(current_generation.load(std::memory_order_relaxed))
+{}
+
+inline void generation_marker::touch() noexcept {
+  const std::uint64_t g = current_generation.load(std::memory_order_relaxed);
+  // The generation only moves forward: a thread that read an older generation,
+  // must not overwrite the touch of a thread that read a newer one.
+  std::uint64_t old = gen_.load(std::memory_order_relaxed);
+  while (old < g && !gen_.compare_exchange_weak(old, g, std::memory_order_relaxed)) {}
+}
+
+inline auto generation_marker::changed_since(std::uint64_t since) const noexcept -> bool {
+  return gen_.load(std::memory_order_relaxed) >= since;
+}
+
+
+} /* namespace instrumentation::detail */
+
+#endif /* INSTRUMENTATION_DETAIL_GENERATION_H */
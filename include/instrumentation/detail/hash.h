@@ -0,0 +1,84 @@
+#ifndef INSTRUMENTATION_DETAIL_HASH_H
+#define INSTRUMENTATION_DETAIL_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace instrumentation::detail {
+
+
+inline constexpr std::uint64_t hash_p0 = 0xa0761d6478bd642full;
+inline constexpr std::uint64_t hash_p1 = 0xe7037ed1a0b428dbull;
+inline constexpr std::uint64_t hash_p2 = 0x8ebc6af09c88c6e3ull;
+
+/**
+ * \brief Multiply two 64-bit values and fold the 128-bit product.
+ * \details
+ * This is the mixing step of wyhash: every input bit affects every output bit.
+ */
+constexpr auto hash_mum(std::uint64_t a, std::uint64_t b) noexcept -> std::uint64_t {
+#ifdef __SIZEOF_INT128__
+  const unsigned __int128 r = static_cast<unsigned __int128>(a) * b;
+  return static_cast<std::uint64_t>(r) ^ static_cast<std::uint64_t>(r >> 64);
+#else
+  const std::uint64_t a_lo = a & 0xffffffffu, a_hi = a >> 32;
+  const std::uint64_t b_lo = b & 0xffffffffu, b_hi = b >> 32;
+  const std::uint64_t ll = a_lo * b_lo, lh = a_lo * b_hi, hl = a_hi * b_lo, hh = a_hi * b_hi;
+  const std::uint64_t mid = (ll >> 32) + (lh & 0xffffffffu) + (hl & 0xffffffffu);
+  const std::uint64_t lo = (mid << 32) | (ll & 0xffffffffu);
+  const std::uint64_t hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+  return lo ^ hi;
+#endif
+}
+
+///\brief Hash a single 64-bit value.
+constexpr auto hash_mix(std::uint64_t v) noexcept -> std::uint64_t {
+  return hash_mum(v ^ hash_p0, hash_p1);
+}
+
+///\brief Combine the hash \p v into the running hash \p seed.
+constexpr auto hash_combine(std::uint64_t seed, std::uint64_t v) noexcept -> std::uint64_t {
+  return hash_mum(seed ^ hash_p2, v ^ hash_p1);
+}
+
+// Little-endian read, written to be usable in constant expressions.
+// Compilers turn this into a single load.
+constexpr auto hash_read_(const char* p, std::size_t n) noexcept -> std::uint64_t {
+  std::uint64_t v = 0;
+  for (std::size_t i = 0; i < n; ++i)
+    v |= std::uint64_t(static_cast<unsigned char>(p[i])) << (8u * i);
+  return v;
+}
+
+/**
+ * \brief Hash a byte sequence.
+ * \details
+ * A simplified wyhash: the input is consumed 16 bytes at a time,
+ * each block folded into the state with a 128-bit multiply.
+ */
+constexpr auto hash_bytes(std::string_view s, std::uint64_t seed = 0) noexcept -> std::uint64_t {
+  const char* p = s.data();
+  std::size_t len = s.size();
+
+  seed ^= hash_p0;
+  for (; len > 16u; len -= 16u, p += 16u)
+    seed = hash_mum(hash_read_(p, 8) ^ hash_p1, hash_read_(p + 8, 8) ^ seed);
+
+  std::uint64_t a = 0, b = 0;
+  if (len >= 8u) {
+    a = hash_read_(p, 8);
+    b = hash_read_(p + len - 8u, 8);
+  } else if (len >= 4u) {
+    a = hash_read_(p, 4);
+    b = hash_read_(p + len - 4u, 4);
+  } else if (len > 0u) {
+    a = (hash_read_(p, 1) << 16) | (hash_read_(p + len / 2u, 1) << 8) | hash_read_(p + len - 1u, 1);
+  }
+  return hash_mum(hash_p1 ^ std::uint64_t(s.size()), hash_mum(a ^ hash_p1, b ^ seed));
+}
+
+
+} /* namespace instrumentation::detail */
+
+#endif /* INSTRUMENTATION_DETAIL_HASH_H */
@@ -4,49 +4,92 @@
 #include <instrumentation/metric_name.h>
 #include <instrumentation/tags.h>
 #include <instrumentation/collector.h>
+#include <instrumentation/expiry.h>
+#include <instrumentation/interned_string.h>
+#include <instrumentation/detail/generation.h>
+#include <instrumentation/detail/hash.h>
+#include <instrumentation/detail/series_map.h>
+#include <instrumentation/detail/stripe.h>
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <shared_mutex>
 #include <string>
+#include <string_view>
+#include <tuple>
 #include <type_traits>
-#include <unordered_map>
+#include <vector>
 
 namespace instrumentation::detail {
 
 
-template<typename LabelSet> struct label_set_hash;
-
-template<typename... LabelTypes>
-struct label_set_hash<std::tuple<LabelTypes...>> {
-  auto operator()(const std::tuple<LabelTypes...>& labels) const noexcept -> std::size_t {
-    return hash_(0u, labels, std::index_sequence_for<LabelTypes...>());
+/**
+ * \brief Hash of a single label value.
+ * \details
+ * Integers and strings are hashed directly.
+ * Interned strings use their precomputed hash.
+ * Other types use std::hash, followed by a mixing step,
+ * since std::hash is allowed to be the identity function.
+ */
+template<typename T>
+auto label_hash(const T& v) noexcept -> std::uint64_t {
+  if constexpr(std::is_same_v<T, interned_string>) {
+    return v.hash();
+  } else if constexpr(std::is_integral_v<T> || std::is_enum_v<T>) {
+    return hash_mix(static_cast<std::uint64_t>(v));
+  } else if constexpr(std::is_convertible_v<const T&, std::string_view>) {
+    return hash_bytes(std::string_view(v));
+  } else {
+    return hash_mix(std::hash<T>()(v));
   }
+}
 
-  private:
-  template<typename T>
-  static auto hash_1_(const T& v) noexcept -> std::size_t {
-    std::hash<T> h;
-    return h(v);
-  }
 
-  template<std::size_t Idx>
-  static auto hash_n_(const std::tuple<LabelTypes...>& labels) noexcept -> std::size_t {
-    return hash_1_(std::get<Idx>(labels));
-  }
+/**
+ * \brief Hash of a label set.
+ * \details
+ * Accepts any tuple whose elements hash the same as the label types,
+ * so that a tuple of string views finds the tuple of strings.
+ */
+template<typename... T>
+auto label_set_hash(const std::tuple<T...>& labels) noexcept -> std::uint64_t {
+  return std::apply(
+      [](const auto&... v) {
+        std::uint64_t outcome = hash_p0;
+        ((outcome = hash_combine(outcome, label_hash(v))), ...);
+        return outcome;
+      },
+      labels);
+}
 
-  static auto hash_(std::size_t outcome, const std::tuple<LabelTypes...>& labels [[maybe_unused]] , std::index_sequence<> indices [[maybe_unused]]) noexcept -> std::size_t {
-    return outcome;
-  }
 
-  template<std::size_t Idx0, std::size_t... Idxs>
-  static auto hash_(std::size_t outcome, const std::tuple<LabelTypes...>& labels, std::index_sequence<Idx0, Idxs...> indices [[maybe_unused]]) noexcept -> std::size_t {
-    outcome = 23u * outcome + hash_n_<Idx0>(labels);
-    return hash_(outcome, labels, std::index_sequence<Idxs...>());
-  }
+/**
+ * \brief Argument type used to look up a label value.
+ * \details
+ * String labels are looked up by string view,
+ * so that looking up an existing series doesn't copy the label value.
+ */
+template<typename T>
+struct label_arg {
+  using type = const T&;
 };
 
+template<>
+struct label_arg<std::string> {
+  using type = std::string_view;
+};
+
+template<typename T>
+using label_arg_t = typename label_arg<T>::type;
+
 
 class metric_group_intf {
   public:
@@ -60,6 +103,8 @@ class metric_group_intf {
   virtual ~metric_group_intf() noexcept = default;
 
   virtual void collect(const metric_name& name, collector& c) const = 0;
+  ///\brief Collect the series that were modified in generation \p since or later.
+  virtual void collect_changed(const metric_name& name, collector& c, std::uint64_t since) const = 0;
 };
 
 
@@ -70,10 +115,42 @@ class metric_group
   public:
   using metric_type = MetricType;
   using label_set = std::tuple<LabelTypes...>;
+  using label_view = std::tuple<label_arg_t<LabelTypes>...>;
   static inline constexpr std::size_t NUM_LABELS = sizeof...(LabelTypes);
 
   protected:
-  using metrics_map = std::unordered_map<label_set, std::shared_ptr<MetricType>, label_set_hash<label_set>>;
+  /**
+   * \brief A single series.
+   * \details
+   * The tags are created and rendered once, when the series is created.
+   * They are shared, so that collection can copy the series while holding the shard lock,
+   * and render it after releasing the lock.
+   */
+  struct series {
+    std::shared_ptr<MetricType> metric;
+    std::shared_ptr<const tags> labels;
+  };
+
+  using metrics_map = series_map<label_set, series>;
+
+  /**
+   * \brief Number of shards the series are split over.
+   * \details
+   * Without labels, there is only a single series, and a single shard suffices.
+   */
+  static inline constexpr std::size_t NUM_SHARDS = (NUM_LABELS == 0 ? 1u : 16u);
+
+  /**
+   * \brief A subset of the series, selected by the hash of their label set.
+   * \details
+   * Each shard has its own lock, on its own cache line,
+   * so lookups of different series don't contend on a single lock.
+   */
+  struct alignas(cache_line_size) shard {
+    // Mutable, since collection removes expired series.
+    mutable metrics_map metrics;
+    mutable std::shared_mutex mtx;
+  };
 
   public:
   template<typename... MetricArgs>
@@ -83,21 +160,75 @@ class metric_group
   ~metric_group() noexcept override = default;
 
   void collect(const metric_name& name, collector& c) const override final;
-  auto get(const label_set& labels) -> std::shared_ptr<metric_type>;
+  void collect_changed(const metric_name& name, collector& c, std::uint64_t since) const override final;
+  /**
+   * \brief Get the metric for the given label values.
+   * \details
+   * The label values are only copied if the metric needs to be created.
+   */
+  auto get(label_arg_t<LabelTypes>... values) -> std::shared_ptr<metric_type>;
+
+  ///\brief Set the policy for removing idle series.
+  void expire(expiry policy);
+  ///\brief Number of series removed by the expiry policy.
+  auto expired() const noexcept -> std::uint64_t;
+
+  /**
+   * \brief Limit the number of series to \p n.
+   * \details
+   * Once the limit is reached, label sets that don't have a series yet
+   * share a single overflow series, whose labels are all set to overflow_label.
+   * The overflow series doesn't count towards the limit.
+   */
+  void limit_series(std::size_t n) noexcept;
+  ///\brief Number of lookups that were directed to the overflow series.
+  auto dropped() const noexcept -> std::uint64_t;
+
+  ///\brief Value of each label of the overflow series.
+  static inline constexpr std::string_view overflow_label = "__overflow__";
 
   private:
-  auto get_existing_(const label_set& labels) const -> std::shared_ptr<metric_type>;
-  virtual auto get_or_create_(const label_set& labels) -> std::shared_ptr<metric_type> = 0;
+  virtual auto get_or_create_(shard& sh, std::uint64_t hash, const label_view& labels) -> std::shared_ptr<metric_type> = 0;
 
   auto make_tags_(const label_set& labels, std::index_sequence<> indices [[maybe_unused]]) const -> tags;
   template<std::size_t Idx0, std::size_t... Idx>
   auto make_tags_(const label_set& labels, std::index_sequence<Idx0, Idx...> indices [[maybe_unused]]) const -> tags;
 
+  auto expiry_threshold_(bool scrape) const -> std::optional<std::uint64_t>;
+  template<typename Pred>
+  void snapshot_(const shard& sh, std::vector<series>& out, std::optional<std::uint64_t> keep_since, Pred&& pred) const;
+  auto overflow_snapshot_() const -> std::optional<series>;
+
   protected:
-  metrics_map metrics_;
-  std::array<std::string, NUM_LABELS> label_names_;
+  auto get_existing_(const shard& sh, std::uint64_t hash, const label_view& labels) const -> std::shared_ptr<metric_type>;
+  auto make_series_(const label_set& labels, std::shared_ptr<metric_type> metric) const -> series;
+  auto shard_for_(std::uint64_t hash) noexcept -> shard&;
+  ///\brief Test if the limit has been reached.
+  auto series_limit_reached_() const noexcept -> bool;
+  ///\brief Account for a new series. Fails if the limit has been reached.
+  auto reserve_series_() noexcept -> bool;
+  ///\brief Undo reserve_series_(), for a series that could not be added.
+  void release_series_() noexcept;
+  ///\brief The overflow series, which is created using \p make_metric if it doesn't exist yet.
+  template<typename MakeMetric>
+  auto overflow_series_(MakeMetric&& make_metric) -> std::shared_ptr<metric_type>;
+
+  std::array<shard, NUM_SHARDS> shards_;
+  std::array<interned_string, NUM_LABELS> label_names_;
   std::string description_;
-  mutable std::shared_mutex mtx_;
+
+  // Expiry policy, and the generation and time of each collection it needs to remember.
+  mutable std::mutex expiry_mtx_;
+  expiry expiry_;
+  mutable std::deque<std::pair<expiry::clock::time_point, std::uint64_t>> collections_;
+  mutable std::atomic<std::uint64_t> expired_{ 0u };
+
+  // Series limit, and the overflow series that takes the label sets past the limit.
+  std::atomic<std::size_t> max_series_{ std::numeric_limits<std::size_t>::max() };
+  mutable std::atomic<std::size_t> series_count_{ 0u };
+  std::atomic<std::uint64_t> dropped_{ 0u };
+  mutable std::mutex overflow_mtx_;
+  std::optional<series> overflow_;
 };
 
 
@@ -108,9 +239,12 @@ class metric_group_impl
   public:
   using metric_type = typename metric_group<MetricType, LabelTypes...>::metric_type;
   using label_set = typename metric_group<MetricType, LabelTypes...>::label_set;
+  using label_view = typename metric_group<MetricType, LabelTypes...>::label_view;
+  using series = typename metric_group<MetricType, LabelTypes...>::series;
 
   protected:
   using metrics_map = typename metric_group<MetricType, LabelTypes...>::metrics_map;
+  using shard = typename metric_group<MetricType, LabelTypes...>::shard;
 
   public:
   template<typename... Args>
@@ -120,7 +254,7 @@ class metric_group_impl
   {}
 
   private:
-  auto get_or_create_(const label_set& labels) -> std::shared_ptr<metric_type> override final;
+  auto get_or_create_(shard& sh, std::uint64_t hash, const label_view& labels) -> std::shared_ptr<metric_type> override final;
 
   const MetricConstructorArgTpl metric_constructor_arg_tpl_;
 };
@@ -136,38 +270,227 @@ auto metric_group<MetricType, LabelTypes...>::make(std::array<std::string, NUM_L
 
 template<typename MetricType, typename... LabelTypes>
 metric_group<MetricType, LabelTypes...>::metric_group(std::array<std::string, NUM_LABELS> label_names, std::string description)
-: label_names_(std::move(label_names)),
-  description_(std::move(description))
-{}
+: description_(std::move(description))
+{
+  // Label names repeat across metric groups, so they're interned.
+  std::copy(label_names.begin(), label_names.end(), label_names_.begin());
+}
 
 template<typename MetricType, typename... LabelTypes>
 void metric_group<MetricType, LabelTypes...>::collect(const metric_name& name, collector& c) const {
-  const std::shared_lock<std::shared_mutex> lck{ mtx_ };
-
   c.visit_description(name, description_);
 
-  for (const auto& tagged_metric : metrics_) {
-    const auto& tags = make_tags_(tagged_metric.first, std::index_sequence_for<LabelTypes...>());
-    const auto& metric = tagged_metric.second;
+  // The collector is invoked without holding any lock,
+  // so a slow collector doesn't block creation of new series.
+  const auto keep_since = expiry_threshold_(true);
+  std::vector<series> snapshot;
+  for (const shard& sh : shards_) {
+    snapshot_(sh, snapshot, keep_since,
+        [](const series& s [[maybe_unused]]) {
+          return true;
+        });
+
+    for (const series& s : snapshot)
+      s.metric->collect(name, *s.labels, c);
+  }
+
+  if (const auto overflow = overflow_snapshot_(); overflow.has_value())
+    overflow->metric->collect(name, *overflow->labels, c);
+}
 
-    metric->collect(name, tags, c);
+template<typename MetricType, typename... LabelTypes>
+void metric_group<MetricType, LabelTypes...>::collect_changed(const metric_name& name, collector& c, std::uint64_t since) const {
+  // Only emit the description if there is at least one series to emit.
+  bool described = false;
+
+  // Incremental collections don't count as scrapes,
+  // so pushing changes often doesn't shorten expiry::after_scrapes().
+  const auto keep_since = expiry_threshold_(false);
+  std::vector<series> snapshot;
+  for (const shard& sh : shards_) {
+    snapshot_(sh, snapshot, keep_since,
+        [since](const series& s) {
+          return s.metric->generation().changed_since(since);
+        });
+
+    for (const series& s : snapshot) {
+      if (!described) {
+        c.visit_description(name, description_);
+        described = true;
+      }
+      s.metric->collect(name, *s.labels, c);
+    }
+  }
+
+  const auto overflow = overflow_snapshot_();
+  if (overflow.has_value() && overflow->metric->generation().changed_since(since)) {
+    if (!described) c.visit_description(name, description_);
+    overflow->metric->collect(name, *overflow->labels, c);
   }
 }
 
 template<typename MetricType, typename... LabelTypes>
-auto metric_group<MetricType, LabelTypes...>::get(const label_set& labels) -> std::shared_ptr<metric_type> {
-  auto m = get_existing_(labels);
-  if (m == nullptr) m = get_or_create_(labels);
+auto metric_group<MetricType, LabelTypes...>::get(label_arg_t<LabelTypes>... values) -> std::shared_ptr<metric_type> {
+  const label_view labels{ values... };
+  const std::uint64_t hash = label_set_hash(labels);
+  shard& sh = shard_for_(hash);
+  auto m = get_existing_(sh, hash, labels);
+  if (m == nullptr) m = get_or_create_(sh, hash, labels);
   return m;
 }
 
 template<typename MetricType, typename... LabelTypes>
-auto metric_group<MetricType, LabelTypes...>::get_existing_(const label_set& labels) const -> std::shared_ptr<metric_type> {
-  const std::shared_lock<std::shared_mutex> lck{ mtx_ };
+auto metric_group<MetricType, LabelTypes...>::get_existing_(const shard& sh, std::uint64_t hash, const label_view& labels) const -> std::shared_ptr<metric_type> {
+  const std::shared_lock<std::shared_mutex> lck{ sh.mtx };
+
+  const auto ptr = sh.metrics.find(hash, labels);
+  if (ptr == nullptr) return nullptr;
+  return ptr->metric;
+}
+
+template<typename MetricType, typename... LabelTypes>
+void metric_group<MetricType, LabelTypes...>::expire(expiry policy) {
+  const std::lock_guard<std::mutex> lck{ expiry_mtx_ };
+  expiry_ = std::move(policy);
+  collections_.clear();
+}
+
+template<typename MetricType, typename... LabelTypes>
+auto metric_group<MetricType, LabelTypes...>::expired() const noexcept -> std::uint64_t {
+  return expired_.load(std::memory_order_relaxed);
+}
+
+/*
+ * Record this collection, and compute the generation from which series are kept.
+ * Series last modified before that generation have been idle long enough to expire.
+ * Returns nothing if no series can expire yet.
+ *
+ * Only full collections (scrape is true) count towards scrape based expiry;
+ * other collections reuse the threshold of the most recent scrape.
+ */
+template<typename MetricType, typename... LabelTypes>
+auto metric_group<MetricType, LabelTypes...>::expiry_threshold_(bool scrape) const -> std::optional<std::uint64_t> {
+  const std::lock_guard<std::mutex> lck{ expiry_mtx_ };
+  if (!expiry_.enabled()) return std::nullopt;
+
+  if (!scrape && expiry_.scrapes() != 0u) {
+    if (collections_.size() <= expiry_.scrapes()) return std::nullopt;
+    return collections_.front().second + 1u;
+  }
+
+  // Series modified after this point record a later generation.
+  const std::uint64_t gen = current_generation.fetch_add(1u, std::memory_order_relaxed);
+  const auto now = expiry::clock::now();
+  collections_.emplace_back(now, gen);
+
+  if (expiry_.scrapes() != 0u) {
+    // Keep the current collection, and the expiry_.scrapes() collections before it.
+    while (collections_.size() > expiry_.scrapes() + 1u) collections_.pop_front();
+    if (collections_.size() <= expiry_.scrapes()) return std::nullopt;
+  } else {
+    // Keep the most recent collection that is at least expiry_.idle_time() old, and anything after it.
+    const auto cutoff = now - expiry_.idle_time();
+    while (collections_.size() > 1u && collections_[1].first <= cutoff) collections_.pop_front();
+    if (collections_.front().first > cutoff) return std::nullopt;
+  }
+  return collections_.front().second + 1u;
+}
+
+template<typename MetricType, typename... LabelTypes>
+template<typename Pred>
+void metric_group<MetricType, LabelTypes...>::snapshot_(const shard& sh, std::vector<series>& out, std::optional<std::uint64_t> keep_since, Pred&& pred) const {
+  out.clear();
+
+  if (!keep_since.has_value()) {
+    const std::shared_lock<std::shared_mutex> lck{ sh.mtx };
+    out.reserve(sh.metrics.size());
+    sh.metrics.for_each(
+        [&out, &pred](const label_set& labels [[maybe_unused]], const series& s) {
+          if (pred(s)) out.push_back(s);
+        });
+    return;
+  }
+
+  const std::lock_guard<std::shared_mutex> lck{ sh.mtx };
+  out.reserve(sh.metrics.size());
+  const std::size_t erased = sh.metrics.erase_if(
+      [&out, &pred, keep_since](const label_set& labels [[maybe_unused]], const series& s) {
+        // A series is only removed if the map holds the only reference to it,
+        // so handles held by the application keep their series alive.
+        // Without handles, nothing can modify the series while the lock is held.
+        if (s.metric.use_count() == 1 && !s.metric->generation().changed_since(*keep_since)) return true;
+
+        if (pred(s)) out.push_back(s);
+        return false;
+      });
+  if (erased != 0u) {
+    expired_.fetch_add(erased, std::memory_order_relaxed);
+    series_count_.fetch_sub(erased, std::memory_order_relaxed);
+  }
+}
+
+template<typename MetricType, typename... LabelTypes>
+auto metric_group<MetricType, LabelTypes...>::overflow_snapshot_() const -> std::optional<series> {
+  const std::lock_guard<std::mutex> lck{ overflow_mtx_ };
+  return overflow_;
+}
+
+template<typename MetricType, typename... LabelTypes>
+void metric_group<MetricType, LabelTypes...>::limit_series(std::size_t n) noexcept {
+  max_series_.store(n, std::memory_order_relaxed);
+}
+
+template<typename MetricType, typename... LabelTypes>
+auto metric_group<MetricType, LabelTypes...>::dropped() const noexcept -> std::uint64_t {
+  return dropped_.load(std::memory_order_relaxed);
+}
+
+template<typename MetricType, typename... LabelTypes>
+auto metric_group<MetricType, LabelTypes...>::series_limit_reached_() const noexcept -> bool {
+  return series_count_.load(std::memory_order_relaxed) >= max_series_.load(std::memory_order_relaxed);
+}
+
+template<typename MetricType, typename... LabelTypes>
+auto metric_group<MetricType, LabelTypes...>::reserve_series_() noexcept -> bool {
+  // Series in different shards are created concurrently, so claim a place first and undo if over the limit.
+  if (series_count_.fetch_add(1u, std::memory_order_relaxed) >= max_series_.load(std::memory_order_relaxed)) {
+    series_count_.fetch_sub(1u, std::memory_order_relaxed);
+    dropped_.fetch_add(1u, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+template<typename MetricType, typename... LabelTypes>
+void metric_group<MetricType, LabelTypes...>::release_series_() noexcept {
+  series_count_.fetch_sub(1u, std::memory_order_relaxed);
+}
 
-  auto iter = metrics_.find(labels);
-  if (iter == metrics_.end()) return nullptr;
-  return iter->second;
+template<typename MetricType, typename... LabelTypes>
+template<typename MakeMetric>
+auto metric_group<MetricType, LabelTypes...>::overflow_series_(MakeMetric&& make_metric) -> std::shared_ptr<metric_type> {
+  const std::lock_guard<std::mutex> lck{ overflow_mtx_ };
+
+  if (!overflow_.has_value()) {
+    tags t;
+    for (const interned_string& label_name : label_names_) t.with(label_name, overflow_label);
+    t.render();
+    overflow_.emplace(series{ std::invoke(std::forward<MakeMetric>(make_metric)), std::make_shared<const tags>(std::move(t)) });
+  }
+  return overflow_->metric;
+}
+
+template<typename MetricType, typename... LabelTypes>
+auto metric_group<MetricType, LabelTypes...>::shard_for_(std::uint64_t hash) noexcept -> shard& {
+  // The series map uses the low bits of the hash, so select the shard using the high bits.
+  return shards_[(hash >> 32) % NUM_SHARDS];
+}
+
+template<typename MetricType, typename... LabelTypes>
+auto metric_group<MetricType, LabelTypes...>::make_series_(const label_set& labels, std::shared_ptr<metric_type> metric) const -> series {
+  tags t = make_tags_(labels, std::index_sequence_for<LabelTypes...>());
+  t.render();
+  return series{ std::move(metric), std::make_shared<const tags>(std::move(t)) };
 }
 
 template<typename MetricType, typename... LabelTypes>
@@ -184,18 +507,42 @@ auto metric_group<MetricType, LabelTypes...>::make_tags_(const label_set& labels
 
 
 template<typename MetricType, typename MetricConstructorArgTpl, typename... LabelTypes>
-auto metric_group_impl<MetricType, MetricConstructorArgTpl, LabelTypes...>::get_or_create_(const label_set& labels) -> std::shared_ptr<metric_type> {
-  auto new_metric = std::apply(
-      [](const auto&... args) {
-        return std::make_shared<metric_type>(args...);
-      },
-      metric_constructor_arg_tpl_);
+auto metric_group_impl<MetricType, MetricConstructorArgTpl, LabelTypes...>::get_or_create_(shard& sh, std::uint64_t hash, const label_view& labels) -> std::shared_ptr<metric_type> {
+  const auto make_metric =
+      [this]() {
+        return std::apply(
+            [](const auto&... args) {
+              return std::make_shared<metric_type>(args...);
+            },
+            metric_constructor_arg_tpl_);
+      };
+
+  // Once the limit is reached, new label sets go to the overflow series
+  // without taking the exclusive lock, so they don't hold up lookups in this shard.
+  if (this->series_limit_reached_()) {
+    // Another thread may have created the metric, since our caller looked it up.
+    if (auto m = this->get_existing_(sh, hash, labels); m != nullptr) return m;
+    this->dropped_.fetch_add(1u, std::memory_order_relaxed);
+    return this->overflow_series_(make_metric);
+  }
+
+  const std::lock_guard<std::shared_mutex> lck{ sh.mtx };
 
-  const std::lock_guard<std::shared_mutex> lck{ this->mtx_ };
+  // Another thread may have created the metric, while we didn't hold the lock.
+  const auto ptr = sh.metrics.find(hash, labels);
+  if (ptr != nullptr) return ptr->metric;
 
-  // Emplace will either create the element, or return the iterator to an existing element.
-  const auto iter = std::get<0>(this->metrics_.emplace(labels, std::move(new_metric)));
-  return iter->second;
+  if (!this->reserve_series_()) return this->overflow_series_(make_metric);
+
+  // Give up the claimed place, if the series can't be added.
+  try {
+    label_set owned_labels(labels);
+    series s = this->make_series_(owned_labels, make_metric());
+    return sh.metrics.emplace(hash, std::move(owned_labels), std::move(s)).metric;
+  } catch (...) {
+    this->release_series_();
+    throw;
+  }
 }
 
 
@@ -0,0 +1,202 @@
+#ifndef INSTRUMENTATION_DETAIL_SERIES_MAP_H
+#define INSTRUMENTATION_DETAIL_SERIES_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace instrumentation::detail {
+
+
+/**
+ * \brief Flat hash table holding the series of a metric group.
+ * \details
+ * Open addressing with linear probing.
+ * The hash of each key is stored in a dense array next to the entries,
+ * so a probe only touches the entry when the full hash matches.
+ *
+ * The map doesn't compute hashes: callers pass the hash with every operation.
+ * The hash must be well mixed, as the slot is selected by its low bits.
+ *
+ * This type is not thread safe.
+ */
+template<typename Key, typename Value>
+class series_map {
+  public:
+  using value_type = std::pair<Key, Value>;
+
+  auto size() const noexcept -> std::size_t { return size_; }
+
+  /**
+   * \brief Find the entry for \p key.
+   * \details
+   * \p key may be of any type that compares equal with Key,
+   * provided its hash is the same as the hash of the equivalent Key.
+   * \returns Pointer to the value, or nullptr if there is no such entry.
+   */
+  template<typename K>
+  auto find(std::uint64_t hash, const K& key) const noexcept -> const Value*;
+  template<typename K>
+  auto find(std::uint64_t hash, const K& key) noexcept -> Value*;
+
+  /**
+   * \brief Add an entry.
+   * \details
+   * The key must not already be present in the map.
+   * \returns Reference to the inserted value.
+   */
+  auto emplace(std::uint64_t hash, Key key, Value value) -> Value&;
+
+  ///\brief Invoke \p fn with each key and value in the map.
+  template<typename Fn>
+  void for_each(Fn&& fn) const;
+
+  /**
+   * \brief Remove the entries for which \p pred returns true.
+   * \details
+   * \p pred is invoked exactly once for each entry, with its key and value.
+   * \returns The number of removed entries.
+   */
+  template<typename Pred>
+  auto erase_if(Pred&& pred) -> std::size_t;
+
+  private:
+  // Hash value 0 marks an empty slot.
+  static constexpr auto marker_(std::uint64_t hash) noexcept -> std::uint64_t { return hash == 0u ? 1u : hash; }
+
+  template<typename K>
+  auto find_slot_(std::uint64_t hash, const K& key) const noexcept -> std::optional<std::size_t>;
+  void erase_slot_(std::size_t i) noexcept;
+  void grow_();
+
+  std::vector<std::uint64_t> hashes_;
+  std::vector<std::optional<value_type>> entries_;
+  std::size_t size_ = 0;
+};
+
+
+template<typename Key, typename Value>
+template<typename K>
+auto series_map<Key, Value>::find(std::uint64_t hash, const K& key) const noexcept -> const Value* {
+  const auto slot = find_slot_(hash, key);
+  if (!slot.has_value()) return nullptr;
+  return &entries_[*slot]->second;
+}
+
+template<typename Key, typename Value>
+template<typename K>
+auto series_map<Key, Value>::find(std::uint64_t hash, const K& key) noexcept -> Value* {
+  const auto slot = find_slot_(hash, key);
+  if (!slot.has_value()) return nullptr;
+  return &entries_[*slot]->second;
+}
+
+template<typename Key, typename Value>
+auto series_map<Key, Value>::emplace(std::uint64_t hash, Key key, Value value) -> Value& {
+  // Keep the load factor at or below 3/4.
+  if (4u * (size_ + 1u) > 3u * hashes_.size()) grow_();
+
+  hash = marker_(hash);
+  const std::size_t mask = hashes_.size() - 1u;
+  std::size_t i = hash & mask;
+  while (hashes_[i] != 0u) i = (i + 1u) & mask;
+
+  hashes_[i] = hash;
+  entries_[i].emplace(std::move(key), std::move(value));
+  ++size_;
+  return entries_[i]->second;
+}
+
+template<typename Key, typename Value>
+template<typename Fn>
+void series_map<Key, Value>::for_each(Fn&& fn) const {
+  for (std::size_t i = 0; i < hashes_.size(); ++i) {
+    if (hashes_[i] != 0u) fn(entries_[i]->first, entries_[i]->second);
+  }
+}
+
+template<typename Key, typename Value>
+template<typename Pred>
+auto series_map<Key, Value>::erase_if(Pred&& pred) -> std::size_t {
+  if (size_ == 0u) return 0;
+
+  /*
+   * Start right after an empty slot, which exists because of the load factor.
+   * Erasing shifts entries backwards, but never across an empty slot.
+   * So entries only move into the current slot, or into slots that haven't been visited yet.
+   */
+  const std::size_t mask = hashes_.size() - 1u;
+  std::size_t start = 0;
+  while (hashes_[start] != 0u) ++start;
+
+  std::size_t erased = 0;
+  for (std::size_t n = 1; n < hashes_.size(); ) {
+    const std::size_t i = (start + n) & mask;
+    if (hashes_[i] != 0u && pred(std::as_const(entries_[i]->first), entries_[i]->second)) {
+      erase_slot_(i);
+      ++erased;
+      continue; // The slot may hold a shifted entry, which must be visited.
+    }
+    ++n;
+  }
+  return erased;
+}
+
+template<typename Key, typename Value>
+void series_map<Key, Value>::erase_slot_(std::size_t i) noexcept {
+  // Backward shift deletion: move later entries of the probe sequence into the hole,
+  // unless that would move them before their home slot.
+  const std::size_t mask = hashes_.size() - 1u;
+  std::size_t hole = i;
+  for (std::size_t j = (i + 1u) & mask; hashes_[j] != 0u; j = (j + 1u) & mask) {
+    const std::size_t home = hashes_[j] & mask;
+    if (((j - home) & mask) >= ((j - hole) & mask)) {
+      hashes_[hole] = hashes_[j];
+      entries_[hole] = std::move(entries_[j]);
+      hole = j;
+    }
+  }
+
+  hashes_[hole] = 0u;
+  entries_[hole].reset();
+  --size_;
+}
+
+template<typename Key, typename Value>
+template<typename K>
+auto series_map<Key, Value>::find_slot_(std::uint64_t hash, const K& key) const noexcept -> std::optional<std::size_t> {
+  if (size_ == 0u) return std::nullopt;
+
+  hash = marker_(hash);
+  const std::size_t mask = hashes_.size() - 1u;
+  for (std::size_t i = hash & mask; hashes_[i] != 0u; i = (i + 1u) & mask) {
+    if (hashes_[i] == hash && entries_[i]->first == key) return i;
+  }
+  return std::nullopt;
+}
+
+template<typename Key, typename Value>
+void series_map<Key, Value>::grow_() {
+  const std::size_t new_size = (hashes_.empty() ? 8u : 2u * hashes_.size());
+  std::vector<std::uint64_t> old_hashes(new_size, 0u);
+  std::vector<std::optional<value_type>> old_entries(new_size);
+  old_hashes.swap(hashes_);
+  old_entries.swap(entries_);
+
+  const std::size_t mask = new_size - 1u;
+  for (std::size_t j = 0; j < old_hashes.size(); ++j) {
+    if (old_hashes[j] == 0u) continue;
+
+    std::size_t i = old_hashes[j] & mask;
+    while (hashes_[i] != 0u) i = (i + 1u) & mask;
+    hashes_[i] = old_hashes[j];
+    entries_[i] = std::move(old_entries[j]);
+  }
+}
+
+
+} /* namespace instrumentation::detail */
+
+#endif /* INSTRUMENTATION_DETAIL_SERIES_MAP_H */
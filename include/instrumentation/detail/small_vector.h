@@ -0,0 +1,182 @@
+#ifndef INSTRUMENTATION_DETAIL_SMALL_VECTOR_H
+#define INSTRUMENTATION_DETAIL_SMALL_VECTOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace instrumentation::detail {
+
+
+/**
+ * \brief Vector that stores up to N elements inline.
+ * \details
+ * Only allocates once it holds more than N elements.
+ * Supports the handful of operations needed by tags.
+ */
+template<typename T, std::size_t N>
+class small_vector {
+  static_assert(N > 0u);
+
+  public:
+  using value_type = T;
+  using iterator = T*;
+  using const_iterator = const T*;
+
+  small_vector() noexcept {}
+
+  small_vector(const small_vector& y)
+  : small_vector()
+  {
+    reserve(y.size());
+    for (const T& v : y) emplace_back(v);
+  }
+
+  small_vector(small_vector&& y) noexcept(std::is_nothrow_move_constructible_v<T>)
+  : small_vector()
+  {
+    steal_(std::move(y));
+  }
+
+  ~small_vector() noexcept {
+    clear();
+    release_();
+  }
+
+  auto operator=(const small_vector& y) -> small_vector& {
+    if (this != &y) {
+      small_vector tmp(y);
+      clear();
+      steal_(std::move(tmp));
+    }
+    return *this;
+  }
+
+  auto operator=(small_vector&& y) noexcept(std::is_nothrow_move_constructible_v<T>) -> small_vector& {
+    if (this != &y) {
+      clear();
+      steal_(std::move(y));
+    }
+    return *this;
+  }
+
+  auto begin() noexcept -> iterator { return data_(); }
+  auto end() noexcept -> iterator { return data_() + size_; }
+  auto begin() const noexcept -> const_iterator { return data_(); }
+  auto end() const noexcept -> const_iterator { return data_() + size_; }
+  auto size() const noexcept -> std::size_t { return size_; }
+  auto empty() const noexcept -> bool { return size_ == 0u; }
+  auto operator[](std::size_t i) noexcept -> T& { return data_()[i]; }
+  auto operator[](std::size_t i) const noexcept -> const T& { return data_()[i]; }
+
+  void reserve(std::size_t n) {
+    if (n <= capacity_) return;
+
+    std::allocator<T> alloc;
+    T* const new_data = alloc.allocate(n);
+    try {
+      std::uninitialized_move(begin(), end(), new_data);
+    } catch (...) {
+      alloc.deallocate(new_data, n);
+      throw;
+    }
+    adopt_(new_data, n);
+  }
+
+  template<typename... Args>
+  auto emplace_back(Args&&... args) -> T& {
+    if (size_ != capacity_) {
+      T* const result = ::new(static_cast<void*>(data_() + size_)) T(std::forward<Args>(args)...);
+      ++size_;
+      return *result;
+    }
+
+    // The arguments may refer to an element, so construct the new element before moving the old ones.
+    const std::size_t n = 2u * capacity_;
+    std::allocator<T> alloc;
+    T* const new_data = alloc.allocate(n);
+    T* result;
+    try {
+      result = ::new(static_cast<void*>(new_data + size_)) T(std::forward<Args>(args)...);
+    } catch (...) {
+      alloc.deallocate(new_data, n);
+      throw;
+    }
+    try {
+      std::uninitialized_move(begin(), end(), new_data);
+    } catch (...) {
+      std::destroy_at(result);
+      alloc.deallocate(new_data, n);
+      throw;
+    }
+    adopt_(new_data, n);
+    ++size_;
+    return *result;
+  }
+
+  ///\brief Insert an element before \p pos.
+  template<typename... Args>
+  auto emplace(const_iterator pos, Args&&... args) -> T& {
+    const std::size_t idx = pos - begin();
+    emplace_back(std::forward<Args>(args)...);
+    std::rotate(begin() + idx, end() - 1, end());
+    return (*this)[idx];
+  }
+
+  void clear() noexcept {
+    std::destroy(begin(), end());
+    size_ = 0;
+  }
+
+  private:
+  auto data_() noexcept -> T* { return heap_ != nullptr ? heap_ : std::launder(reinterpret_cast<T*>(inline_)); }
+  auto data_() const noexcept -> const T* { return heap_ != nullptr ? heap_ : std::launder(reinterpret_cast<const T*>(inline_)); }
+
+  // Take the elements of y. This must be empty.
+  void steal_(small_vector&& y) {
+    if (y.heap_ != nullptr) {
+      release_();
+      heap_ = std::exchange(y.heap_, nullptr);
+      capacity_ = std::exchange(y.capacity_, N);
+      size_ = std::exchange(y.size_, 0u);
+    } else {
+      reserve(y.size_);
+      std::uninitialized_move(y.begin(), y.end(), begin());
+      size_ = y.size_;
+      y.clear();
+    }
+  }
+
+  // Replace the storage with new_data, which holds the moved elements.
+  void adopt_(T* new_data, std::size_t n) noexcept {
+    std::destroy(begin(), end());
+    const std::size_t sz = std::exchange(size_, 0u);
+    release_();
+    heap_ = new_data;
+    capacity_ = n;
+    size_ = sz;
+  }
+
+  // Release the heap storage. The vector must be empty.
+  void release_() noexcept {
+    if (heap_ != nullptr) {
+      std::allocator<T>().deallocate(heap_, capacity_);
+      heap_ = nullptr;
+      capacity_ = N;
+    }
+  }
+
+  alignas(T) unsigned char inline_[N * sizeof(T)];
+  T* heap_ = nullptr;
+  std::size_t size_ = 0;
+  std::size_t capacity_ = N;
+};
+
+
+} /* namespace instrumentation::detail */
+
+#endif /* INSTRUMENTATION_DETAIL_SMALL_VECTOR_H */
@@ -0,0 +1,29 @@
+#ifndef INSTRUMENTATION_DETAIL_STRIPE_H
+#define INSTRUMENTATION_DETAIL_STRIPE_H
+
+#include <atomic>
+#include <cstddef>
+
+namespace instrumentation::detail {
+
+
+///\brief Size of a cache line, used to keep concurrently modified data apart.
+inline constexpr std::size_t cache_line_size = 64;
+
+/**
+ * \brief Stripe index of the calling thread.
+ * \details
+ * Each thread is handed a sequence number the first time it asks for one.
+ * Striped data structures use this number, masked by their stripe count,
+ * to select the stripe the thread modifies.
+ */
+inline auto stripe_index() noexcept -> std::size_t {
+  static std::atomic<std::size_t> next{ 0u };
+  thread_local const std::size_t idx = next.fetch_add(1u, std::memory_order_relaxed);
+  return idx;
+}
+
+
+} /* namespace instrumentation::detail */
+
+#endif /* INSTRUMENTATION_DETAIL_STRIPE_H */
@@ -2,10 +2,13 @@
 #define INSTRUMENTATION_ENGINE_H
 
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 #include <instrumentation/detail/export_.h>
 #include <instrumentation/metric_name.h>
 #include <instrumentation/tags.h>
@@ -25,10 +28,59 @@ class engine {
   instrumentation_export_
   void collect(collector& c) const;
 
+  /**
+   * \brief Position in the sequence of modifications, used by collect_changed.
+   * \details
+   * A default constructed cursor is at the start,
+   * so the first collect_changed using it visits all series.
+   */
+  class cursor {
+    friend engine;
+
+    private:
+    std::uint64_t since_ = 0;
+  };
+
+  /**
+   * \brief Collect only the series that were modified since the previous call with the same cursor.
+   * \details
+   * The description of a metric group is only visited, if at least one of its series is visited.
+   *
+   * A series that is modified while collection is running, may be visited again by the next call.
+   * A modification is never missed.
+   */
+  instrumentation_export_
+  void collect_changed(collector& c, cursor& cur) const;
+
+  /**
+   * \brief Collect all metrics, using multiple threads.
+   * \details
+   * The metric groups are split into one contiguous chunk per collector,
+   * in the same order as collect visits them.
+   * So visiting the collectors in order sees the same sequence as a single collect would.
+   *
+   * Chunks are handed out to at most \p threads threads, including the calling thread.
+   * Each collector is only used by a single thread.
+   *
+   * If a collector throws, the remaining chunks are still collected,
+   * and the first exception is rethrown.
+   */
+  instrumentation_export_
+  void collect_parallel(const std::vector<collector*>& collectors, unsigned int threads) const;
+
   template<typename MetricCb>
   auto get_metric(metric_name name, MetricCb&& cb) -> std::shared_ptr<detail::metric_group_intf>;
 
   private:
+  /**
+   * \brief Registered metric groups, in collection order.
+   * \details
+   * Metric groups are never removed, so the name pointers remain valid for the lifetime of the engine.
+   */
+  using group_snapshot = std::vector<std::pair<const metric_name*, std::shared_ptr<detail::metric_group_intf>>>;
+
+  ///\brief Copy the registered metric groups, holding the lock only while copying.
+  auto snapshot_() const -> group_snapshot;
   auto get_existing_(const metric_name& name) const -> std::shared_ptr<detail::metric_group_intf>;
   template<typename MetricCb>
   auto get_or_create_(metric_name&& name, MetricCb&& cb) -> std::shared_ptr<detail::metric_group_intf>;
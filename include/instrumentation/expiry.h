@@ -0,0 +1,69 @@
+#ifndef INSTRUMENTATION_EXPIRY_H
+#define INSTRUMENTATION_EXPIRY_H
+
+#include <chrono>
+#include <cstddef>
+#include <stdexcept>
+
+namespace instrumentation {
+
+
+/**
+ * \brief Policy for removing idle series from a metric vector.
+ * \details
+ * A series is idle, if it was not modified during the last few collections,
+ * or during the last stretch of time.
+ * Expiry is checked when the metric vector is collected,
+ * so a vector that is never collected never loses series.
+ *
+ * Only full collections, such as a prometheus scrape, count towards after_scrapes().
+ * Collections of changed series (engine::collect_changed(), used by push exporters)
+ * remove series that the most recent full collection found idle, but don't advance the count.
+ * A vector that is only pushed should use a time based policy, after().
+ *
+ * A series is only removed if no handle to it exists outside the vector.
+ * A removed series is recreated, with its initial value, when it is next looked up.
+ *
+ * The default policy never removes series.
+ */
+class expiry {
+  public:
+  using clock = std::chrono::steady_clock;
+
+  ///\brief Never remove series.
+  expiry() noexcept = default;
+
+  ///\brief Remove series that were not modified during the last \p n full collections.
+  static auto after_scrapes(std::size_t n) -> expiry {
+    if (n == 0u) throw std::logic_error("expiry requires at least one scrape");
+
+    expiry result;
+    result.scrapes_ = n;
+    return result;
+  }
+
+  ///\brief Remove series that were not modified for at least \p d.
+  static auto after(clock::duration d) -> expiry {
+    if (d <= clock::duration::zero()) throw std::logic_error("expiry requires a positive duration");
+
+    expiry result;
+    result.idle_time_ = d;
+    return result;
+  }
+
+  ///\brief Test if this policy removes series.
+  auto enabled() const noexcept -> bool { return scrapes_ != 0u || idle_time_ != clock::duration::zero(); }
+  ///\brief Number of collections after which a series expires, or 0 if expiry is time based.
+  auto scrapes() const noexcept -> std::size_t { return scrapes_; }
+  ///\brief Duration after which a series expires, or zero if expiry is scrape based.
+  auto idle_time() const noexcept -> clock::duration { return idle_time_; }
+
+  private:
+  std::size_t scrapes_ = 0;
+  clock::duration idle_time_ = clock::duration::zero();
+};
+
+
+} /* namespace instrumentation */
+
+#endif /* INSTRUMENTATION_EXPIRY_H */
@@ -9,12 +9,20 @@ class collector;
 
 class counter;
 template<typename... LabelTypes> class counter_vector;
+class counter_u64;
+template<typename... LabelTypes> class counter_u64_vector;
 class gauge;
 template<typename... LabelTypes> class gauge_vector;
+class gauge_i64;
+template<typename... LabelTypes> class gauge_i64_vector;
 class string;
 template<typename... LabelTypes> class string_vector;
 class timing;
 template<typename... LabelTypes> class timing_vector;
+class summary;
+template<typename... LabelTypes> class summary_vector;
+template<typename Counter> class basic_counter_batch;
+class timing_batch;
 
 
 } /* namespace instrumentation */
@@ -23,9 +31,12 @@ namespace instrumentation::detail {
 
 
 class counter_impl;
+class counter_u64_impl;
 class gauge_impl;
+class gauge_i64_impl;
 class string_impl;
 class timing_impl;
+class summary_impl;
 
 
 } /* namespace instrumentation::detail */
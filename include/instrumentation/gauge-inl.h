@@ -90,14 +90,36 @@ gauge_vector<LabelTypes...>::gauge_vector(
 {}
 
 template<typename... LabelTypes>
-auto gauge_vector<LabelTypes...>::labels(const LabelTypes&... values) const -> gauge {
+auto gauge_vector<LabelTypes...>::labels(detail::label_arg_t<LabelTypes>... values) const -> gauge {
   gauge result;
   if (impl_ == nullptr) return result;
 
-  result.impl_ = impl_->get(std::make_tuple(values...));
+  result.impl_ = impl_->get(values...);
   return result;
 }
 
+template<typename... LabelTypes>
+void gauge_vector<LabelTypes...>::expire(expiry policy) const {
+  if (impl_ != nullptr) impl_->expire(std::move(policy));
+}
+
+template<typename... LabelTypes>
+auto gauge_vector<LabelTypes...>::expired() const noexcept -> std::uint64_t {
+  if (impl_ == nullptr) return 0;
+  return impl_->expired();
+}
+
+template<typename... LabelTypes>
+void gauge_vector<LabelTypes...>::limit_series(std::size_t n) const noexcept {
+  if (impl_ != nullptr) impl_->limit_series(n);
+}
+
+template<typename... LabelTypes>
+auto gauge_vector<LabelTypes...>::dropped() const noexcept -> std::uint64_t {
+  if (impl_ == nullptr) return 0;
+  return impl_->dropped();
+}
+
 template<typename... LabelTypes>
 gauge_vector<LabelTypes...>::operator bool() const noexcept {
   return impl_ != nullptr;
@@ -119,6 +141,7 @@ inline void gauge_impl::inc(double d) noexcept {
   while (!v_.compare_exchange_weak(expect, expect + d, std::memory_order_relaxed, std::memory_order_relaxed)) {
     // SKIP
   }
+  generation_.touch();
 }
 
 inline void gauge_impl::dec(double d) noexcept {
@@ -126,10 +149,12 @@ inline void gauge_impl::dec(double d) noexcept {
   while (!v_.compare_exchange_weak(expect, expect - d, std::memory_order_relaxed, std::memory_order_relaxed)) {
     // SKIP
   }
+  generation_.touch();
 }
 
 inline void gauge_impl::set(double d) noexcept {
   v_.store(d, std::memory_order_relaxed);
+  generation_.touch();
 }
 
 inline auto gauge_impl::get() const noexcept -> double {
@@ -142,6 +167,10 @@ inline void gauge_impl::collect(const metric_name& name, const tags& tags, colle
   return c.visit(name, tags, tmp);
 }
 
+inline auto gauge_impl::generation() const noexcept -> const generation_marker& {
+  return generation_;
+}
+
 
 } /* namespace instrumentation::detail */
 
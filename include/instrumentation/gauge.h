@@ -2,9 +2,12 @@
 #define INSTRUMENTATION_GAUGE_H
 
 #include <instrumentation/fwd.h>
+#include <instrumentation/expiry.h>
 #include <instrumentation/detail/metric_group.h>
 #include <array>
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <memory>
 
@@ -20,9 +23,12 @@ class gauge_impl
   void set(double d) noexcept;
   auto get() const noexcept -> double;
   void collect(const metric_name& name, const tags& tags, collector& c);
+  ///\brief Generation in which this metric was last modified.
+  auto generation() const noexcept -> const generation_marker&;
 
   private:
   std::atomic<double> v_{ 0.0 };
+  generation_marker generation_;
 };
 
 
@@ -67,7 +73,16 @@ class gauge_vector {
   gauge_vector(std::string_view name, std::array<std::string, sizeof...(LabelTypes)> labels, std::string description = "");
   gauge_vector(engine& e, std::string_view name, std::array<std::string, sizeof...(LabelTypes)> labels, std::string description = "");
 
-  auto labels(const LabelTypes&... values) const -> gauge;
+  auto labels(detail::label_arg_t<LabelTypes>... values) const -> gauge;
+
+  ///\brief Set the policy for removing idle series.
+  void expire(expiry policy) const;
+  ///\brief Number of series removed by the expiry policy.
+  auto expired() const noexcept -> std::uint64_t;
+  ///\brief Limit the number of series, directing further label sets to a shared overflow series.
+  void limit_series(std::size_t n) const noexcept;
+  ///\brief Number of lookups that were directed to the overflow series.
+  auto dropped() const noexcept -> std::uint64_t;
 
   explicit operator bool() const noexcept;
   auto operator!() const noexcept -> bool;
@@ -0,0 +1,171 @@
+#ifndef INSTRUMENTATION_GAUGE_I64_INL_H
+#define INSTRUMENTATION_GAUGE_I64_INL_H
+
+#include <instrumentation/engine.h>
+#include <instrumentation/collector.h>
+
+namespace instrumentation {
+
+
+inline void gauge_i64::operator++() const noexcept {
+  if (impl_) impl_->inc();
+}
+
+inline void gauge_i64::operator++(int) const noexcept {
+  if (impl_) impl_->inc();
+}
+
+inline void gauge_i64::operator--() const noexcept {
+  if (impl_) impl_->dec();
+}
+
+inline void gauge_i64::operator--(int) const noexcept {
+  if (impl_) impl_->dec();
+}
+
+inline void gauge_i64::operator+=(std::int64_t d) const noexcept {
+  if (impl_) impl_->inc(d);
+}
+
+inline void gauge_i64::operator-=(std::int64_t d) const noexcept {
+  if (impl_) impl_->dec(d);
+}
+
+inline void gauge_i64::operator=(std::int64_t d) const noexcept {
+  if (impl_) impl_->set(d);
+}
+
+inline gauge_i64::operator bool() const noexcept {
+  return impl_ != nullptr;
+}
+
+inline auto gauge_i64::operator!() const noexcept -> bool {
+  return impl_ == nullptr;
+}
+
+inline auto gauge_i64::operator*() const -> std::int64_t {
+  if (!impl_) return 0;
+  return impl_->get();
+}
+
+
+template<typename... LabelTypes>
+gauge_i64_vector<LabelTypes...>::gauge_i64_vector(
+    metric_name name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    std::string description)
+: gauge_i64_vector(engine::global(), std::move(name), std::move(labels), std::move(description))
+{}
+
+template<typename... LabelTypes>
+gauge_i64_vector<LabelTypes...>::gauge_i64_vector(
+    engine& e,
+    metric_name name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    std::string description) {
+  const auto raw_metric = e.get_metric(
+      std::move(name),
+      [&labels, &description]() {
+        return group_type::make(std::move(labels), std::move(description));
+      });
+  // We silently allow for a null impl if the metric doesn't match type.
+  impl_ = std::dynamic_pointer_cast<group_type>(raw_metric);
+}
+
+template<typename... LabelTypes>
+gauge_i64_vector<LabelTypes...>::gauge_i64_vector(
+    std::string_view name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    std::string description)
+: gauge_i64_vector(metric_name(name), std::move(labels), std::move(description))
+{}
+
+template<typename... LabelTypes>
+gauge_i64_vector<LabelTypes...>::gauge_i64_vector(
+    engine& e,
+    std::string_view name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    std::string description)
+: gauge_i64_vector(e, metric_name(name), std::move(labels), std::move(description))
+{}
+
+template<typename... LabelTypes>
+auto gauge_i64_vector<LabelTypes...>::labels(detail::label_arg_t<LabelTypes>... values) const -> gauge_i64 {
+  gauge_i64 result;
+  if (impl_ == nullptr) return result;
+
+  result.impl_ = impl_->get(values...);
+  return result;
+}
+
+template<typename... LabelTypes>
+void gauge_i64_vector<LabelTypes...>::expire(expiry policy) const {
+  if (impl_ != nullptr) impl_->expire(std::move(policy));
+}
+
+template<typename... LabelTypes>
+auto gauge_i64_vector<LabelTypes...>::expired() const noexcept -> std::uint64_t {
+  if (impl_ == nullptr) return 0;
+  return impl_->expired();
+}
+
+template<typename... LabelTypes>
+void gauge_i64_vector<LabelTypes...>::limit_series(std::size_t n) const noexcept {
+  if (impl_ != nullptr) impl_->limit_series(n);
+}
+
+template<typename... LabelTypes>
+auto gauge_i64_vector<LabelTypes...>::dropped() const noexcept -> std::uint64_t {
+  if (impl_ == nullptr) return 0;
+  return impl_->dropped();
+}
+
+template<typename... LabelTypes>
+gauge_i64_vector<LabelTypes...>::operator bool() const noexcept {
+  return impl_ != nullptr;
+}
+
+template<typename... LabelTypes>
+auto gauge_i64_vector<LabelTypes...>::operator!() const noexcept -> bool {
+  return impl_ == nullptr;
+}
+
+
+} /* namespace instrumentation */
+
+namespace instrumentation::detail {
+
+
+inline void gauge_i64_impl::inc(std::int64_t d) noexcept {
+  v_.fetch_add(d, std::memory_order_relaxed);
+  generation_.touch();
+}
+
+inline void gauge_i64_impl::dec(std::int64_t d) noexcept {
+  v_.fetch_sub(d, std::memory_order_relaxed);
+  generation_.touch();
+}
+
+inline void gauge_i64_impl::set(std::int64_t d) noexcept {
+  v_.store(d, std::memory_order_relaxed);
+  generation_.touch();
+}
+
+inline auto gauge_i64_impl::get() const noexcept -> std::int64_t {
+  return v_.load(std::memory_order_relaxed);
+}
+
+inline void gauge_i64_impl::collect(const metric_name& name, const tags& tags, collector& c) {
+  gauge_i64 tmp;
+  tmp.impl_ = shared_from_this();
+  return c.visit(name, tags, tmp);
+}
+
+inline auto gauge_i64_impl::generation() const noexcept -> const generation_marker& {
+  return generation_;
+}
+
+
+} /* namespace instrumentation::detail */
+
+#endif /* INSTRUMENTATION_GAUGE_I64_INL_H */
@@ -0,0 +1,105 @@
+#ifndef INSTRUMENTATION_GAUGE_I64_H
+#define INSTRUMENTATION_GAUGE_I64_H
+
+#include <instrumentation/fwd.h>
+#include <instrumentation/expiry.h>
+#include <instrumentation/detail/metric_group.h>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <memory>
+
+namespace instrumentation::detail {
+
+
+class gauge_i64_impl
+: public std::enable_shared_from_this<gauge_i64_impl>
+{
+  public:
+  void inc(std::int64_t d = 1) noexcept;
+  void dec(std::int64_t d = 1) noexcept;
+  void set(std::int64_t d) noexcept;
+  auto get() const noexcept -> std::int64_t;
+  void collect(const metric_name& name, const tags& tags, collector& c);
+  ///\brief Generation in which this metric was last modified.
+  auto generation() const noexcept -> const generation_marker&;
+
+  private:
+  std::atomic<std::int64_t> v_{ 0 };
+  generation_marker generation_;
+};
+
+
+} /* namespace instrumentation::detail */
+
+namespace instrumentation {
+
+
+/**
+ * \brief Integer valued gauge.
+ * \details
+ * Like gauge, but holds a whole number.
+ * Increments and decrements are a single atomic add.
+ */
+class gauge_i64 {
+  friend detail::gauge_i64_impl;
+  template<typename... LabelTypes> friend class gauge_i64_vector;
+
+  public:
+  gauge_i64() = default;
+
+  void operator++() const noexcept;
+  void operator++(int) const noexcept;
+  void operator--() const noexcept;
+  void operator--(int) const noexcept;
+  void operator+=(std::int64_t d) const noexcept;
+  void operator-=(std::int64_t d) const noexcept;
+  void operator=(std::int64_t d) const noexcept;
+
+  explicit operator bool() const noexcept;
+  auto operator!() const noexcept -> bool;
+  auto operator*() const -> std::int64_t;
+
+  private:
+  std::shared_ptr<detail::gauge_i64_impl> impl_;
+};
+
+
+template<typename... LabelTypes>
+class gauge_i64_vector {
+  private:
+  using group_type = detail::metric_group<detail::gauge_i64_impl, LabelTypes...>;
+
+  public:
+  gauge_i64_vector() noexcept = default;
+  gauge_i64_vector(metric_name name, std::array<std::string, sizeof...(LabelTypes)> labels, std::string description = "");
+  gauge_i64_vector(engine& e, metric_name name, std::array<std::string, sizeof...(LabelTypes)> labels, std::string description = "");
+  gauge_i64_vector(std::string_view name, std::array<std::string, sizeof...(LabelTypes)> labels, std::string description = "");
+  gauge_i64_vector(engine& e, std::string_view name, std::array<std::string, sizeof...(LabelTypes)> labels, std::string description = "");
+
+  auto labels(detail::label_arg_t<LabelTypes>... values) const -> gauge_i64;
+
+  ///\brief Set the policy for removing idle series.
+  void expire(expiry policy) const;
+  ///\brief Number of series removed by the expiry policy.
+  auto expired() const noexcept -> std::uint64_t;
+  ///\brief Limit the number of series, directing further label sets to a shared overflow series.
+  void limit_series(std::size_t n) const noexcept;
+  ///\brief Number of lookups that were directed to the overflow series.
+  auto dropped() const noexcept -> std::uint64_t;
+
+  explicit operator bool() const noexcept;
+  auto operator!() const noexcept -> bool;
+
+  private:
+  std::shared_ptr<group_type> impl_;
+};
+
+
+} /* namespace instrumentation */
+
+#include "gauge_i64-inl.h"
+
+#endif /* INSTRUMENTATION_GAUGE_I64_H */
@@ -0,0 +1,94 @@
+#ifndef INSTRUMENTATION_HTTP_H
+#define INSTRUMENTATION_HTTP_H
+
+#include <instrumentation/detail/export_.h>
+#include <instrumentation/fwd.h>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace instrumentation {
+
+
+///\brief Settings for the http_exporter.
+struct http_options {
+  ///\brief Path at which the metrics are served.
+  std::string path = "/metrics";
+  /**
+   * \brief Interval during which a rendered response is reused.
+   * \details
+   * Scrapes that arrive within this interval after a render are answered with the same response,
+   * so concurrent scrapers don't each render the metrics.
+   * Zero renders the metrics for every scrape.
+   */
+  std::chrono::milliseconds max_age = std::chrono::milliseconds(1000);
+};
+
+
+/**
+ * \brief Minimal HTTP/1.1 server exposing the metrics of an engine.
+ * \details
+ * The exporter serves the metrics on a single path, using a background thread.
+ * It answers `GET` and `HEAD` requests, with the prometheus text format,
+ * or with the protobuf format if the `Accept` header asks for it.
+ * If the `Accept-Encoding` header allows gzip, and the library was built with zlib,
+ * the response is compressed while it is rendered.
+ * Connections are kept alive, and pipelined requests are answered in order.
+ *
+ * Responses are rendered into buffers that are reused between renders,
+ * and are sent from those buffers without copying.
+ * Connections that are still sending an older response keep that response alive.
+ *
+ * The engine must outlive the exporter.
+ *
+ * This is only available on Linux, when the `instrumentation_http` library is built.
+ */
+class http_exporter {
+  public:
+  /**
+   * \brief Serve the metrics of \p e on a TCP address.
+   * \param e The engine whose metrics are served.
+   * \param host Numeric IPv4 or IPv6 address to listen on.
+   * \param port Port to listen on. If zero, a free port is chosen; see port().
+   * \param opts Exporter settings.
+   * \throw std::system_error if the address can't be bound.
+   */
+  instrumentation_http_export_
+  static auto tcp(const engine& e, const std::string& host, std::uint16_t port, http_options opts = http_options()) -> http_exporter;
+
+  /**
+   * \brief Serve the metrics of \p e on a unix domain socket.
+   * \details
+   * Any file at \p path is replaced.
+   * The socket file is removed when the exporter is destroyed.
+   * \throw std::system_error if the socket can't be bound.
+   */
+  instrumentation_http_export_
+  static auto unix_socket(const engine& e, const std::string& path, http_options opts = http_options()) -> http_exporter;
+
+  instrumentation_http_export_
+  http_exporter(http_exporter&&) noexcept;
+  instrumentation_http_export_
+  auto operator=(http_exporter&&) noexcept -> http_exporter&;
+
+  ///\brief Close all connections and stop the background thread.
+  instrumentation_http_export_
+  ~http_exporter() noexcept;
+
+  ///\brief TCP port the exporter listens on, or zero for a unix domain socket.
+  instrumentation_http_export_
+  auto port() const noexcept -> std::uint16_t;
+
+  private:
+  class impl;
+
+  explicit http_exporter(std::unique_ptr<impl> impl) noexcept;
+
+  std::unique_ptr<impl> impl_;
+};
+
+
+} /* namespace instrumentation */
+
+#endif /* INSTRUMENTATION_HTTP_H */
@@ -0,0 +1,118 @@
+#ifndef INSTRUMENTATION_INTERNED_STRING_H
+#define INSTRUMENTATION_INTERNED_STRING_H
+
+#include <instrumentation/detail/export_.h>
+#include <instrumentation/detail/hash.h>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace instrumentation::detail {
+
+
+///\brief An entry in the intern pool.
+struct intern_entry {
+  std::uint64_t hash;
+  std::string text;
+};
+
+/**
+ * \brief Find or add \p s in the process-wide intern pool.
+ * \details
+ * Entries are never removed, so the result remains valid until the program exits.
+ * Strings with the same content always yield the same entry.
+ */
+instrumentation_export_
+auto intern(std::string_view s, std::uint64_t hash) -> const intern_entry&;
+
+
+} /* namespace instrumentation::detail */
+
+namespace instrumentation {
+
+
+/**
+ * \brief An interned string.
+ * \details
+ * The string is stored once, in a process-wide pool, and is never released.
+ * An interned string is a single pointer: copying, comparing and hashing it doesn't touch the string.
+ *
+ * Use it as a label type for label values that repeat across many series,
+ * such as request methods or endpoint names.
+ * Creating an interned string looks up the pool, so label values used on hot paths
+ * are best interned once, and kept.
+ *
+ * Since strings are never released, don't intern unbounded values, such as request IDs.
+ */
+class interned_string {
+  public:
+  ///\brief The empty string.
+  constexpr interned_string() noexcept = default;
+
+  interned_string(std::string_view s);
+  interned_string(const std::string& s);
+  interned_string(const char* s);
+
+  auto view() const noexcept -> std::string_view;
+  auto hash() const noexcept -> std::uint64_t;
+  auto empty() const noexcept -> bool;
+
+  operator std::string_view() const noexcept { return view(); }
+
+  auto operator==(const interned_string& y) const noexcept -> bool { return entry_ == y.entry_; }
+  auto operator!=(const interned_string& y) const noexcept -> bool { return entry_ != y.entry_; }
+
+  private:
+  // Null for the empty string.
+  const detail::intern_entry* entry_ = nullptr;
+};
+
+
+inline interned_string::interned_string(std::string_view s) {
+  if (!s.empty()) entry_ = &detail::intern(s, detail::hash_bytes(s));
+}
+
+inline interned_string::interned_string(const std::string& s)
+: interned_string(std::string_view(s))
+{}
+
+inline interned_string::interned_string(const char* s)
+: interned_string(std::string_view(s))
+{}
+
+inline auto interned_string::view() const noexcept -> std::string_view {
+  if (entry_ == nullptr) return std::string_view();
+  return entry_->text;
+}
+
+inline auto interned_string::hash() const noexcept -> std::uint64_t {
+  if (entry_ == nullptr) return detail::hash_bytes(std::string_view());
+  return entry_->hash;
+}
+
+inline auto interned_string::empty() const noexcept -> bool {
+  return entry_ == nullptr;
+}
+
+
+} /* namespace instrumentation */
+
+namespace std {
+
+
+template<>
+struct hash<instrumentation::interned_string> {
+  // These are deprecated in c++17.
+  using argument_type = instrumentation::interned_string;
+  using result_type = std::size_t;
+
+  auto operator()(const instrumentation::interned_string& s) const noexcept -> std::size_t {
+    return static_cast<std::size_t>(s.hash());
+  }
+};
+
+
+} /* namespace std */
+
+#endif /* INSTRUMENTATION_INTERNED_STRING_H */
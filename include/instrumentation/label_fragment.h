@@ -0,0 +1,56 @@
+#ifndef INSTRUMENTATION_LABEL_FRAGMENT_H
+#define INSTRUMENTATION_LABEL_FRAGMENT_H
+
+#include <instrumentation/detail/export_.h>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace instrumentation {
+
+
+class tags;
+
+/**
+ * \brief Serialized form of a set of tags.
+ * \details
+ * The tags are rendered as `name="value",` pairs, sorted by name.
+ * Names are sanitized, and values quoted and escaped,
+ * as required by the prometheus text format.
+ *
+ * A series renders its fragment once, when it is created,
+ * so that exporters can append the fragment, instead of rendering the tags on each scrape.
+ */
+class label_fragment {
+  public:
+  instrumentation_export_
+  explicit label_fragment(const tags& t);
+
+  ///\brief The rendered tags.
+  auto text() const noexcept -> std::string_view { return text_; }
+  ///\brief Test if there are no tags.
+  auto empty() const noexcept -> bool { return text_.empty(); }
+
+  /**
+   * \brief Find the position of the tag with the given sanitized name.
+   * \returns
+   * The range `[begin, end)` of the pair for \p name, if it is present.
+   * Otherwise, the empty range at the position where it would be inserted.
+   */
+  instrumentation_export_
+  auto locate(std::string_view name) const noexcept -> std::pair<std::size_t, std::size_t>;
+
+  private:
+  auto name_(std::size_t i) const noexcept -> std::string_view;
+
+  std::string text_;
+  ///\brief Start offset of each pair in text_.
+  std::vector<std::size_t> offsets_;
+};
+
+
+} /* namespace instrumentation */
+
+#endif /* INSTRUMENTATION_LABEL_FRAGMENT_H */
@@ -2,6 +2,8 @@
 #define INSTRUMENTATION_METRIC_NAME_H
 
 #include <instrumentation/detail/export_.h>
+#include <instrumentation/detail/hash.h>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <initializer_list>
@@ -16,14 +18,27 @@ namespace instrumentation {
  * \brief Models a metric name.
  * \details
  * A metric name is a sequence of path elements, forming a path.
+ *
+ * The name is stored as its dotted path, together with the hash of that path.
+ * The path text is never owned by the name:
+ * names created at runtime refer to a copy of the path in the intern pool, which lives until the program exits,
+ * and names created from a literal refer to the literal.
+ * So copying a name is cheap, and comparing or hashing names doesn't touch the path elements.
+ *
+ * Path elements are separated by a dot, so a path element can't contain a dot.
  */
 class metric_name {
   public:
   ///\brief Construct an empty path.
-  metric_name() = default;
+  constexpr metric_name() noexcept = default;
 
-  ///\brief Construct a path with the given path elements.
-  metric_name(std::initializer_list<std::string> elements);
+  /**
+   * \brief Construct a path with the given path elements.
+   * \details
+   * Any dot in an element separates it into multiple elements.
+   */
+  instrumentation_export_
+  metric_name(std::initializer_list<std::string_view> elements);
 
   /**
    * \brief Construct a path from a strring.
@@ -37,39 +52,76 @@ class metric_name {
   instrumentation_export_
   metric_name(std::string_view path);
 
+  /**
+   * \brief Construct a path from a string that outlives the program.
+   * \details
+   * The \p path is neither copied nor interned, and its hash can be computed at compile time.
+   * Use the `_metric` literal, which guarantees the lifetime requirement.
+   */
+  static constexpr auto from_static(std::string_view path) noexcept -> metric_name;
+
   ///\brief Render the path using the given separator between path components.
   instrumentation_export_
   auto with_separator(std::string_view sep = ".") const -> std::string;
   ///\brief Test if this is an empty path.
-  auto empty() const noexcept -> bool;
-  ///\brief Inspect the underlying vector of path components.
-  auto data() const noexcept -> const std::vector<std::string>&;
-  ///\brief Allow modification of underlying path components.
-  auto data() noexcept -> std::vector<std::string>&;
+  constexpr auto empty() const noexcept -> bool;
+  ///\brief The path, with the path elements separated by a dot.
+  constexpr auto path() const noexcept -> std::string_view;
+  ///\brief The path elements.
+  instrumentation_export_
+  auto elements() const -> std::vector<std::string_view>;
+  ///\brief Hash of the path, computed when the name was constructed.
+  constexpr auto hash() const noexcept -> std::uint64_t;
 
-  auto operator==(const metric_name& y) const noexcept { return elements == y.elements; }
-  auto operator!=(const metric_name& y) const noexcept { return !(*this == y); }
+  constexpr auto operator==(const metric_name& y) const noexcept -> bool;
+  constexpr auto operator!=(const metric_name& y) const noexcept -> bool { return !(*this == y); }
 
   private:
-  ///\brief Sequence of path elements.
-  std::vector<std::string> elements;
+  constexpr metric_name(std::string_view path, std::uint64_t hash) noexcept
+  : path_(path),
+    hash_(hash)
+  {}
+
+  ///\brief Dotted path.
+  std::string_view path_;
+  ///\brief Hash of path_.
+  std::uint64_t hash_ = detail::hash_bytes(std::string_view());
 };
 
 
-inline metric_name::metric_name(std::initializer_list<std::string> elements)
-: elements(elements)
-{}
+inline namespace literals {
+
 
-inline auto metric_name::empty() const noexcept -> bool {
-  return data().empty();
+///\brief Metric name literal: `"http.server.requests"_metric` is hashed at compile time, and never interned.
+constexpr auto operator""_metric(const char* path, std::size_t len) noexcept -> metric_name {
+  return metric_name::from_static(std::string_view(path, len));
 }
 
-inline auto metric_name::data() const noexcept -> const std::vector<std::string>& {
-  return elements;
+
+} /* inline namespace instrumentation::literals */
+
+
+constexpr auto metric_name::from_static(std::string_view path) noexcept -> metric_name {
+  return metric_name(path, detail::hash_bytes(path));
+}
+
+constexpr auto metric_name::empty() const noexcept -> bool {
+  return path_.empty();
 }
 
-inline auto metric_name::data() noexcept -> std::vector<std::string>& {
-  return elements;
+constexpr auto metric_name::path() const noexcept -> std::string_view {
+  return path_;
+}
+
+constexpr auto metric_name::hash() const noexcept -> std::uint64_t {
+  return hash_;
+}
+
+constexpr auto metric_name::operator==(const metric_name& y) const noexcept -> bool {
+  // Interned names with the same path share their text, so the text is only compared for literals.
+  return hash_ == y.hash_
+      && path_.size() == y.path_.size()
+      && (path_.data() == y.path_.data() || path_ == y.path_);
 }
 
 
@@ -84,8 +136,9 @@ struct hash<instrumentation::metric_name> {
   using argument_type = instrumentation::metric_name;
   using result_type = std::size_t;
 
-  instrumentation_export_
-  auto operator()(const instrumentation::metric_name& name) const noexcept -> std::size_t;
+  auto operator()(const instrumentation::metric_name& name) const noexcept -> std::size_t {
+    return static_cast<std::size_t>(name.hash());
+  }
 };
 
 
@@ -5,20 +5,126 @@
 #include <instrumentation/fwd.h>
 #include <iosfwd>
 #include <string>
+#include <string_view>
 
 namespace instrumentation {
 
 
+///\brief Content type of the prometheus text format.
+inline constexpr std::string_view prometheus_content_type = "text/plain; version=0.0.4";
+///\brief Content type of the prometheus protobuf format.
+inline constexpr std::string_view prometheus_protobuf_content_type = "application/vnd.google.protobuf; proto=io.prometheus.client.MetricFamily; encoding=delimited";
+///\brief Content encoding of the gzip compressed variants.
+inline constexpr std::string_view gzip_content_encoding = "gzip";
+
+///\brief Test if the gzip compressed variants are available, which requires the library to be built with zlib.
+instrumentation_export_
+auto prometheus_gzip_supported() noexcept -> bool;
+
 instrumentation_export_
 void collect_prometheus(std::ostream& out);
 instrumentation_export_
 void collect_prometheus(std::ostream& out, const engine& e);
 
+/**
+ * \brief Append the prometheus text representation of the metrics to \p out.
+ * \details
+ * Reusing the same string for successive scrapes avoids reallocating its buffer.
+ */
+instrumentation_export_
+void collect_prometheus(std::string& out);
+instrumentation_export_
+void collect_prometheus(std::string& out, const engine& e);
+
 instrumentation_export_
 auto collect_prometheus() -> std::string;
 instrumentation_export_
 auto collect_prometheus(const engine& e) -> std::string;
 
+/**
+ * \brief Append the prometheus text representation of the metrics to \p out, using multiple threads.
+ * \details
+ * Each thread renders into its own buffer, and the buffers are concatenated.
+ * The output is identical to that of collect_prometheus.
+ * \param threads Maximum number of threads to use, including the calling thread.
+ */
+instrumentation_export_
+void collect_prometheus_parallel(std::string& out, const engine& e, unsigned int threads);
+instrumentation_export_
+auto collect_prometheus_parallel(const engine& e, unsigned int threads) -> std::string;
+
+/**
+ * \brief Write the prometheus text representation of the metrics, compressed with gzip.
+ * \details
+ * The text is compressed as it is rendered, a chunk at a time,
+ * so the uncompressed text is never held in full.
+ * Decompressing the output yields the output of collect_prometheus.
+ *
+ * The string variants append the compressed output to \p out.
+ * \throw std::logic_error if the library was built without zlib.
+ */
+instrumentation_export_
+void collect_prometheus_gzip(std::ostream& out);
+instrumentation_export_
+void collect_prometheus_gzip(std::ostream& out, const engine& e);
+
+instrumentation_export_
+void collect_prometheus_gzip(std::string& out);
+instrumentation_export_
+void collect_prometheus_gzip(std::string& out, const engine& e);
+
+instrumentation_export_
+auto collect_prometheus_gzip() -> std::string;
+instrumentation_export_
+auto collect_prometheus_gzip(const engine& e) -> std::string;
+
+/**
+ * \brief Write the metrics in the prometheus protobuf format.
+ * \details
+ * The output is a sequence of length-delimited `io.prometheus.client.MetricFamily` messages.
+ * Histograms carry their buckets natively, without an explicit `+Inf` bucket.
+ * Since timings don't track the sum of their samples, the histogram sample sum is not set.
+ */
+instrumentation_export_
+void collect_prometheus_protobuf(std::ostream& out);
+instrumentation_export_
+void collect_prometheus_protobuf(std::ostream& out, const engine& e);
+
+instrumentation_export_
+void collect_prometheus_protobuf(std::string& out);
+instrumentation_export_
+void collect_prometheus_protobuf(std::string& out, const engine& e);
+
+instrumentation_export_
+auto collect_prometheus_protobuf() -> std::string;
+instrumentation_export_
+auto collect_prometheus_protobuf(const engine& e) -> std::string;
+
+///\brief Protobuf equivalent of collect_prometheus_parallel.
+instrumentation_export_
+void collect_prometheus_protobuf_parallel(std::string& out, const engine& e, unsigned int threads);
+instrumentation_export_
+auto collect_prometheus_protobuf_parallel(const engine& e, unsigned int threads) -> std::string;
+
+/**
+ * \brief Protobuf equivalent of collect_prometheus_gzip.
+ * \throw std::logic_error if the library was built without zlib.
+ */
+instrumentation_export_
+void collect_prometheus_protobuf_gzip(std::ostream& out);
+instrumentation_export_
+void collect_prometheus_protobuf_gzip(std::ostream& out, const engine& e);
+
+instrumentation_export_
+void collect_prometheus_protobuf_gzip(std::string& out);
+instrumentation_export_
+void collect_prometheus_protobuf_gzip(std::string& out, const engine& e);
+
+instrumentation_export_
+auto collect_prometheus_protobuf_gzip() -> std::string;
+instrumentation_export_
+auto collect_prometheus_protobuf_gzip(const engine& e) -> std::string;
+
 
 } /* namespace instrumentation */
 
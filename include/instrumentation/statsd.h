@@ -0,0 +1,118 @@
+#ifndef INSTRUMENTATION_STATSD_H
+#define INSTRUMENTATION_STATSD_H
+
+#include <instrumentation/detail/export_.h>
+#include <instrumentation/fwd.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace instrumentation {
+
+
+///\brief Settings for the statsd_exporter.
+struct statsd_options {
+  ///\brief Interval between flushes.
+  std::chrono::milliseconds interval = std::chrono::seconds(10);
+  ///\brief Prepended to each metric name, for example `"myapp."`.
+  std::string prefix;
+  /**
+   * \brief Largest datagram that is sent.
+   * \details
+   * The default fits in a single ethernet frame, after IP and UDP headers.
+   * A line that is longer than this is sent in a datagram of its own.
+   */
+  std::size_t max_datagram = 1432;
+  /**
+   * \brief Number of flushes from one full flush to the next.
+   * \details
+   * A full flush visits every series, instead of only those modified since the previous flush.
+   * The exporter then forgets the counter totals of series that no longer exist, such as expired series.
+   * Gauges are sent on a full flush, even if they weren't modified.
+   */
+  std::size_t full_flush_interval = 60;
+};
+
+
+/**
+ * \brief Pushes the metrics of an engine to a StatsD server.
+ * \details
+ * A background thread flushes the engine at each interval.
+ * Each flush only visits the series that were modified since the previous flush,
+ * except for a periodic full flush (statsd_options::full_flush_interval),
+ * and packs as many lines as fit into each datagram.
+ *
+ * Metrics are translated as follows:
+ * - counters are sent as counters (`|c`), with the increment since the previous flush;
+ * - gauges are sent as gauges (`|g`);
+ * - timings are sent as counters `<name>.bucket`, with an `le` tag holding the upper bound of the bucket in seconds,
+ *   and `<name>.count`, all with their increments since the previous flush;
+ * - summaries are sent as gauges, with a `quantile` tag holding the quantile and the value in seconds,
+ *   and as counters `<name>.count` and `<name>.sum`;
+ * - strings are not sent, since StatsD has no equivalent.
+ *
+ * Tags are sent in the DogStatsD form, `|#name:value,...`.
+ *
+ * Sending never blocks: a datagram that can't be sent immediately is dropped, and counted in dropped().
+ * Instrumented threads are only affected by the collection, as they are by a scrape.
+ *
+ * The engine must outlive the exporter.
+ *
+ * This is only available when the `instrumentation_statsd` library is built.
+ */
+class statsd_exporter {
+  public:
+  /**
+   * \brief Push the metrics of \p e to a StatsD server over UDP.
+   * \param e The engine whose metrics are sent.
+   * \param host Numeric IPv4 or IPv6 address of the server.
+   * \param port Port of the server.
+   * \param opts Exporter settings.
+   * \throw std::invalid_argument if \p host is not a numeric address.
+   * \throw std::system_error if the socket can't be created.
+   */
+  instrumentation_statsd_export_
+  static auto udp(const engine& e, const std::string& host, std::uint16_t port, statsd_options opts = statsd_options()) -> statsd_exporter;
+
+  /**
+   * \brief Push the metrics of \p e to a StatsD server on a unix domain datagram socket.
+   * \throw std::system_error if the socket can't be connected.
+   */
+  instrumentation_statsd_export_
+  static auto unix_socket(const engine& e, const std::string& path, statsd_options opts = statsd_options()) -> statsd_exporter;
+
+  instrumentation_statsd_export_
+  statsd_exporter(statsd_exporter&&) noexcept;
+  instrumentation_statsd_export_
+  auto operator=(statsd_exporter&&) noexcept -> statsd_exporter&;
+
+  ///\brief Stop the background thread, after a final flush.
+  instrumentation_statsd_export_
+  ~statsd_exporter() noexcept;
+
+  ///\brief Send the changes since the previous flush now, without waiting for the interval.
+  instrumentation_statsd_export_
+  void flush();
+
+  ///\brief Number of datagrams that could not be sent.
+  instrumentation_statsd_export_
+  auto dropped() const noexcept -> std::uint64_t;
+
+  ///\brief Number of counters whose totals are remembered, to compute the increment at the next flush.
+  instrumentation_statsd_export_
+  auto counters() const -> std::size_t;
+
+  private:
+  class impl;
+
+  explicit statsd_exporter(std::unique_ptr<impl> impl) noexcept;
+
+  std::unique_ptr<impl> impl_;
+};
+
+
+} /* namespace instrumentation */
+
+#endif /* INSTRUMENTATION_STATSD_H */
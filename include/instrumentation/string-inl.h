@@ -66,14 +66,36 @@ string_vector<LabelTypes...>::string_vector(
 {}
 
 template<typename... LabelTypes>
-auto string_vector<LabelTypes...>::labels(const LabelTypes&... values) const -> string {
+auto string_vector<LabelTypes...>::labels(detail::label_arg_t<LabelTypes>... values) const -> string {
   string result;
   if (impl_ == nullptr) return result;
 
-  result.impl_ = impl_->get(std::make_tuple(values...));
+  result.impl_ = impl_->get(values...);
   return result;
 }
 
+template<typename... LabelTypes>
+void string_vector<LabelTypes...>::expire(expiry policy) const {
+  if (impl_ != nullptr) impl_->expire(std::move(policy));
+}
+
+template<typename... LabelTypes>
+auto string_vector<LabelTypes...>::expired() const noexcept -> std::uint64_t {
+  if (impl_ == nullptr) return 0;
+  return impl_->expired();
+}
+
+template<typename... LabelTypes>
+void string_vector<LabelTypes...>::limit_series(std::size_t n) const noexcept {
+  if (impl_ != nullptr) impl_->limit_series(n);
+}
+
+template<typename... LabelTypes>
+auto string_vector<LabelTypes...>::dropped() const noexcept -> std::uint64_t {
+  if (impl_ == nullptr) return 0;
+  return impl_->dropped();
+}
+
 template<typename... LabelTypes>
 string_vector<LabelTypes...>::operator bool() const noexcept {
   return impl_ != nullptr;
@@ -93,6 +115,7 @@ namespace instrumentation::detail {
 inline void string_impl::set(std::string s) {
   std::lock_guard<std::shared_mutex> lck{ mtx_ };
   v_ = std::move(s);
+  generation_.touch();
 }
 
 inline auto string_impl::get() const -> std::string {
@@ -106,6 +129,10 @@ inline void string_impl::collect(const metric_name& name, const tags& tags, coll
   return c.visit(name, tags, tmp);
 }
 
+inline auto string_impl::generation() const noexcept -> const generation_marker& {
+  return generation_;
+}
+
 
 } /* namespace instrumentation::detail */
 
@@ -2,9 +2,12 @@
 #define INSTRUMENTATION_STRING_H
 
 #include <instrumentation/fwd.h>
+#include <instrumentation/expiry.h>
 #include <instrumentation/detail/metric_group.h>
 #include <array>
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <shared_mutex>
@@ -20,10 +23,13 @@ class string_impl
   void set(std::string s);
   auto get() const -> std::string;
   void collect(const metric_name& name, const tags& tags, collector& c);
+  ///\brief Generation in which this metric was last modified.
+  auto generation() const noexcept -> const generation_marker&;
 
   private:
   mutable std::shared_mutex mtx_;
   std::string v_;
+  generation_marker generation_;
 };
 
 
@@ -62,7 +68,16 @@ class string_vector {
   string_vector(std::string_view name, std::array<std::string, sizeof...(LabelTypes)> labels, std::string description = "");
   string_vector(engine& e, std::string_view name, std::array<std::string, sizeof...(LabelTypes)> labels, std::string description = "");
 
-  auto labels(const LabelTypes&... values) const -> string;
+  auto labels(detail::label_arg_t<LabelTypes>... values) const -> string;
+
+  ///\brief Set the policy for removing idle series.
+  void expire(expiry policy) const;
+  ///\brief Number of series removed by the expiry policy.
+  auto expired() const noexcept -> std::uint64_t;
+  ///\brief Limit the number of series, directing further label sets to a shared overflow series.
+  void limit_series(std::size_t n) const noexcept;
+  ///\brief Number of lookups that were directed to the overflow series.
+  auto dropped() const noexcept -> std::uint64_t;
 
   explicit operator bool() const noexcept;
   auto operator!() const noexcept -> bool;
@@ -0,0 +1,52 @@
+#ifndef INSTRUMENTATION_STRIPED_H
+#define INSTRUMENTATION_STRIPED_H
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+
+namespace instrumentation {
+
+
+/**
+ * \brief Request a striped metric.
+ * \details
+ * A striped metric spreads its updates over a number of cache-line padded cells.
+ * Each thread updates the cell selected by its stripe index,
+ * so threads don't contend on a single cache line.
+ * Reading the metric sums all cells.
+ *
+ * Striping trades memory and read cost for cheap concurrent updates.
+ */
+class striped {
+  public:
+  ///\brief Upper limit on the number of stripes.
+  static inline constexpr std::size_t max_size = 256;
+
+  ///\brief Use a stripe count based on the hardware concurrency.
+  striped() noexcept
+  : striped(std::thread::hardware_concurrency())
+  {}
+
+  /**
+   * \brief Use \p n stripes.
+   * \details
+   * The number is rounded up to a power of two, and clamped to max_size.
+   * A single stripe means the metric is not striped.
+   */
+  explicit striped(std::size_t n) noexcept {
+    n = std::clamp(n, std::size_t(1), max_size);
+    while (n_ < n) n_ *= 2u;
+  }
+
+  ///\brief Number of stripes, always a power of two.
+  auto size() const noexcept -> std::size_t { return n_; }
+
+  private:
+  std::size_t n_ = 1;
+};
+
+
+} /* namespace instrumentation */
+
+#endif /* INSTRUMENTATION_STRIPED_H */
@@ -0,0 +1,199 @@
+#ifndef INSTRUMENTATION_SUMMARY_INL_H
+#define INSTRUMENTATION_SUMMARY_INL_H
+
+#include <instrumentation/engine.h>
+#include <instrumentation/collector.h>
+#include <string_view>
+
+namespace instrumentation {
+
+
+inline auto summary::operator<<(duration d) const noexcept -> const summary& {
+  if (impl_) impl_->inc(d);
+  return *this;
+}
+
+inline auto summary::quantile(double q) const -> duration {
+  if (impl_) return impl_->quantile(q);
+  return duration(0);
+}
+
+inline summary::operator bool() const noexcept {
+  return impl_ != nullptr;
+}
+
+inline auto summary::operator!() const noexcept -> bool {
+  return impl_ == nullptr;
+}
+
+inline auto summary::operator*() const -> std::tuple<std::vector<quantile_entry>, std::uint64_t, duration> {
+  if (impl_) return impl_->get_quantiles();
+  return std::make_tuple(std::vector<quantile_entry>(), std::uint64_t(0), duration(0));
+}
+
+
+template<typename... LabelTypes>
+summary_vector<LabelTypes...>::summary_vector(
+    metric_name name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    std::string description)
+: summary_vector(std::move(name), std::move(labels), default_quantiles(), default_relative_accuracy, std::move(description))
+{}
+
+template<typename... LabelTypes>
+summary_vector<LabelTypes...>::summary_vector(
+    metric_name name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    std::vector<double> quantiles,
+    double relative_accuracy,
+    std::string description)
+: summary_vector(engine::global(), std::move(name), std::move(labels), std::move(quantiles), relative_accuracy, std::move(description))
+{}
+
+template<typename... LabelTypes>
+summary_vector<LabelTypes...>::summary_vector(
+    engine& e,
+    metric_name name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    std::string description)
+: summary_vector(e, std::move(name), std::move(labels), default_quantiles(), default_relative_accuracy, std::move(description))
+{}
+
+template<typename... LabelTypes>
+summary_vector<LabelTypes...>::summary_vector(
+    engine& e,
+    metric_name name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    std::vector<double> quantiles,
+    double relative_accuracy,
+    std::string description) {
+  const auto raw_metric = e.get_metric(
+      std::move(name),
+      [&labels, &description, &quantiles, relative_accuracy]() {
+        return group_type::make(std::move(labels), std::move(description), std::move(quantiles), relative_accuracy);
+      });
+  // We silently allow for a null impl if the metric doesn't match type.
+  impl_ = std::dynamic_pointer_cast<group_type>(raw_metric);
+}
+
+template<typename... LabelTypes>
+summary_vector<LabelTypes...>::summary_vector(
+    std::string_view name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    std::string description)
+: summary_vector(metric_name(name), std::move(labels), std::move(description))
+{}
+
+template<typename... LabelTypes>
+summary_vector<LabelTypes...>::summary_vector(
+    engine& e,
+    std::string_view name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    std::string description)
+: summary_vector(e, metric_name(name), std::move(labels), std::move(description))
+{}
+
+template<typename... LabelTypes>
+summary_vector<LabelTypes...>::summary_vector(
+    std::string_view name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    std::vector<double> quantiles,
+    double relative_accuracy,
+    std::string description)
+: summary_vector(metric_name(name), std::move(labels), std::move(quantiles), relative_accuracy, std::move(description))
+{}
+
+template<typename... LabelTypes>
+summary_vector<LabelTypes...>::summary_vector(
+    engine& e,
+    std::string_view name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    std::vector<double> quantiles,
+    double relative_accuracy,
+    std::string description)
+: summary_vector(e, metric_name(name), std::move(labels), std::move(quantiles), relative_accuracy, std::move(description))
+{}
+
+template<typename... LabelTypes>
+auto summary_vector<LabelTypes...>::labels(detail::label_arg_t<LabelTypes>... values) const -> summary {
+  summary result;
+  if (impl_ == nullptr) return result;
+
+  result.impl_ = impl_->get(values...);
+  return result;
+}
+
+template<typename... LabelTypes>
+void summary_vector<LabelTypes...>::expire(expiry policy) const {
+  if (impl_ != nullptr) impl_->expire(std::move(policy));
+}
+
+template<typename... LabelTypes>
+auto summary_vector<LabelTypes...>::expired() const noexcept -> std::uint64_t {
+  if (impl_ == nullptr) return 0;
+  return impl_->expired();
+}
+
+template<typename... LabelTypes>
+void summary_vector<LabelTypes...>::limit_series(std::size_t n) const noexcept {
+  if (impl_ != nullptr) impl_->limit_series(n);
+}
+
+template<typename... LabelTypes>
+auto summary_vector<LabelTypes...>::dropped() const noexcept -> std::uint64_t {
+  if (impl_ == nullptr) return 0;
+  return impl_->dropped();
+}
+
+template<typename... LabelTypes>
+summary_vector<LabelTypes...>::operator bool() const noexcept {
+  return impl_ != nullptr;
+}
+
+template<typename... LabelTypes>
+auto summary_vector<LabelTypes...>::operator!() const noexcept -> bool {
+  return impl_ == nullptr;
+}
+
+
+} /* namespace instrumentation */
+
+namespace instrumentation::detail {
+
+
+inline void summary_impl::collect(const metric_name& name, const tags& tags, collector& c) {
+  summary tmp;
+  tmp.impl_ = shared_from_this();
+  return c.visit(name, tags, tmp);
+}
+
+inline auto summary_impl::generation() const noexcept -> const generation_marker& {
+  return generation_;
+}
+
+inline auto operator==(const summary_impl::quantile_entry& x, const summary_impl::quantile_entry& y) noexcept -> bool {
+  return x.quantile == y.quantile && x.value == y.value;
+}
+
+inline auto operator!=(const summary_impl::quantile_entry& x, const summary_impl::quantile_entry& y) noexcept -> bool {
+  return !(x == y);
+}
+
+template<typename Char, typename Traits>
+auto operator<<(std::basic_ostream<Char, Traits>& out, const summary_impl::quantile_entry& entry) -> std::basic_ostream<Char, Traits>& {
+  using namespace std::string_view_literals;
+
+  for (char c : "summary::quantile_entry{quantile="sv) out.put(out.widen(c));
+  out << entry.quantile;
+  for (char c : ", "sv) out.put(out.widen(c));
+  out << std::chrono::duration<double>(entry.value).count();
+  out.put(out.widen('s'));
+  out.put(out.widen('}'));
+
+  return out;
+}
+
+
+} /* namespace instrumentation::detail */
+
+#endif /* INSTRUMENTATION_SUMMARY_INL_H */
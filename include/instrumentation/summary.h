@@ -0,0 +1,182 @@
+#ifndef INSTRUMENTATION_SUMMARY_H
+#define INSTRUMENTATION_SUMMARY_H
+
+#include <instrumentation/fwd.h>
+#include <instrumentation/expiry.h>
+#include <instrumentation/detail/metric_group.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace instrumentation::detail {
+
+
+/**
+ * \brief Quantile sketch for durations.
+ * \details
+ * The sketch is a DDSketch: durations are counted in bins whose bounds
+ * grow geometrically by a factor `gamma = (1 + a) / (1 - a)`,
+ * where `a` is the relative accuracy.
+ * Any quantile is then estimated with a relative error of at most `a`.
+ *
+ * Bins are allocated in chunks, on first use, so the memory used is
+ * proportional to the range of recorded durations, and bounded by the
+ * range of the duration type.
+ * Recording is lock-free.
+ */
+class summary_impl
+: public std::enable_shared_from_this<summary_impl>
+{
+  public:
+  using clock_type = std::chrono::high_resolution_clock;
+  using duration = clock_type::duration;
+
+  struct quantile_entry {
+    double quantile;
+    duration value;
+  };
+
+  private:
+  static inline constexpr std::size_t chunk_size = 64;
+
+  struct chunk {
+    std::atomic<std::uint64_t> v[chunk_size] = {};
+  };
+
+  public:
+  instrumentation_export_
+  summary_impl(std::vector<double> quantiles, double relative_accuracy);
+  instrumentation_export_
+  ~summary_impl() noexcept;
+
+  instrumentation_export_
+  void inc(duration d, std::uint64_t v = 1) noexcept;
+  ///\brief Estimate quantile \p q, in the range [0, 1].
+  instrumentation_export_
+  auto quantile(double q) const -> duration;
+  ///\brief Estimate the configured quantiles, and return them with the count and sum.
+  instrumentation_export_
+  auto get_quantiles() const -> std::tuple<std::vector<quantile_entry>, std::uint64_t, duration>;
+  void collect(const metric_name& name, const tags& tags, collector& c);
+  ///\brief Generation in which this metric was last modified.
+  auto generation() const noexcept -> const generation_marker&;
+
+  instrumentation_export_
+  static auto default_quantiles() -> std::vector<double>;
+  static inline constexpr double default_relative_accuracy = 0.01;
+
+  private:
+  auto key_(duration::rep x) const noexcept -> std::size_t;
+  auto value_(std::size_t key) const noexcept -> duration;
+  auto quantile_(double q, const std::vector<std::uint64_t>& bins, std::uint64_t zero, std::uint64_t count) const -> duration;
+  auto bins_() const -> std::tuple<std::vector<std::uint64_t>, std::uint64_t, std::uint64_t>;
+
+  const std::vector<double> quantiles_;
+  const double gamma_;
+  const double inv_log_gamma_;
+  const std::size_t nchunks_;
+  std::unique_ptr<std::atomic<chunk*>[]> chunks_;
+  ///\brief Count of durations that are zero or negative.
+  std::atomic<std::uint64_t> zero_{ 0u };
+  std::atomic<duration::rep> sum_{ 0 };
+  generation_marker generation_;
+};
+
+auto operator==(const summary_impl::quantile_entry& x, const summary_impl::quantile_entry& y) noexcept -> bool;
+auto operator!=(const summary_impl::quantile_entry& x, const summary_impl::quantile_entry& y) noexcept -> bool;
+
+template<typename Char, typename Traits>
+auto operator<<(std::basic_ostream<Char, Traits>& out, const summary_impl::quantile_entry& entry) -> std::basic_ostream<Char, Traits>&;
+
+
+} /* namespace instrumentation::detail */
+
+namespace instrumentation {
+
+
+/**
+ * \brief Duration summary, reporting quantiles.
+ * \details
+ * Where a timing counts durations in fixed buckets,
+ * a summary estimates quantiles with a bounded relative error,
+ * independent of the range of the durations.
+ */
+class summary {
+  friend detail::summary_impl;
+  template<typename... LabelTypes> friend class summary_vector;
+
+  public:
+  using clock_type = detail::summary_impl::clock_type;
+  using duration = detail::summary_impl::duration;
+  using quantile_entry = detail::summary_impl::quantile_entry;
+
+  public:
+  auto operator<<(duration d) const noexcept -> const summary&;
+
+  ///\brief Estimate quantile \p q, in the range [0, 1].
+  auto quantile(double q) const -> duration;
+
+  explicit operator bool() const noexcept;
+  auto operator!() const noexcept -> bool;
+  ///\brief Estimate the configured quantiles, and return them with the count and sum.
+  auto operator*() const -> std::tuple<std::vector<quantile_entry>, std::uint64_t, duration>;
+
+  private:
+  std::shared_ptr<detail::summary_impl> impl_;
+};
+
+
+template<typename... LabelTypes>
+class summary_vector {
+  private:
+  using group_type = detail::metric_group<detail::summary_impl, LabelTypes...>;
+
+  public:
+  using clock_type = summary::clock_type;
+  using duration = summary::duration;
+
+  static auto default_quantiles() -> std::vector<double> { return detail::summary_impl::default_quantiles(); }
+  static inline constexpr double default_relative_accuracy = detail::summary_impl::default_relative_accuracy;
+
+  summary_vector() noexcept = default;
+  summary_vector(metric_name name, std::array<std::string, sizeof...(LabelTypes)> labels, std::string description = "");
+  summary_vector(engine& e, metric_name name, std::array<std::string, sizeof...(LabelTypes)> labels, std::string description = "");
+  summary_vector(metric_name name, std::array<std::string, sizeof...(LabelTypes)> labels, std::vector<double> quantiles, double relative_accuracy, std::string description);
+  summary_vector(engine& e, metric_name name, std::array<std::string, sizeof...(LabelTypes)> labels, std::vector<double> quantiles, double relative_accuracy, std::string description);
+
+  summary_vector(std::string_view name, std::array<std::string, sizeof...(LabelTypes)> labels, std::string description = "");
+  summary_vector(engine& e, std::string_view name, std::array<std::string, sizeof...(LabelTypes)> labels, std::string description = "");
+  summary_vector(std::string_view name, std::array<std::string, sizeof...(LabelTypes)> labels, std::vector<double> quantiles, double relative_accuracy, std::string description);
+  summary_vector(engine& e, std::string_view name, std::array<std::string, sizeof...(LabelTypes)> labels, std::vector<double> quantiles, double relative_accuracy, std::string description);
+
+  auto labels(detail::label_arg_t<LabelTypes>... values) const -> summary;
+
+  ///\brief Set the policy for removing idle series.
+  void expire(expiry policy) const;
+  ///\brief Number of series removed by the expiry policy.
+  auto expired() const noexcept -> std::uint64_t;
+  ///\brief Limit the number of series, directing further label sets to a shared overflow series.
+  void limit_series(std::size_t n) const noexcept;
+  ///\brief Number of lookups that were directed to the overflow series.
+  auto dropped() const noexcept -> std::uint64_t;
+
+  explicit operator bool() const noexcept;
+  auto operator!() const noexcept -> bool;
+
+  private:
+  std::shared_ptr<group_type> impl_;
+};
+
+
+} /* namespace instrumentation */
+
+#include "summary-inl.h"
+
+#endif /* INSTRUMENTATION_SUMMARY_H */
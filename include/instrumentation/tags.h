@@ -1,22 +1,64 @@
 #ifndef INSTRUMENTATION_TAGS_H
 #define INSTRUMENTATION_TAGS_H
 
+#include <instrumentation/label_fragment.h>
+#include <instrumentation/detail/small_vector.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <initializer_list>
+#include <memory>
+#include <stdexcept>
 #include <string>
-#include <tuple>
-#include <unordered_map>
+#include <string_view>
+#include <type_traits>
 #include <utility>
 #include <variant>
 
 namespace instrumentation {
 
 
+/**
+ * \brief Set of named tags.
+ * \details
+ * Tags are kept sorted by name, in a flat vector that stores a few tags inline.
+ * So building tags with a handful of entries allocates only for the strings,
+ * and iterating visits the tags in name order.
+ */
 class tags {
   public:
   using tag_value = std::variant<bool, std::int64_t, double, std::string>;
+  using value_type = std::pair<std::string, tag_value>;
+  using const_iterator = const value_type*;
+
+  ///\brief Number of tags stored without allocating.
+  static inline constexpr std::size_t inline_size = 4;
+
+  /**
+   * \brief Read only view of the tags, returned by the deprecated data().
+   * \details
+   * Offers the lookup functions of the map that data() used to return.
+   * Tags are visited in order of name.
+   */
+  class data_view {
+    public:
+    explicit data_view(const tags& t) noexcept : t_(t) {}
+
+    auto begin() const noexcept -> const_iterator { return t_.begin(); }
+    auto end() const noexcept -> const_iterator { return t_.end(); }
+    auto size() const noexcept -> std::size_t { return t_.size(); }
+    auto empty() const noexcept -> bool { return t_.empty(); }
+    auto find(std::string_view name) const noexcept -> const_iterator;
+    auto count(std::string_view name) const noexcept -> std::size_t { return t_.count(name); }
+    auto at(std::string_view name) const -> const tag_value&;
+
+    private:
+    const tags& t_;
+  };
 
   tags() = default;
 
+  ///\brief Create tags from \p init. If a name is repeated, the first occurrence is used.
   tags(std::initializer_list<std::pair<const std::string, tag_value>> init);
 
   template<typename T>
@@ -24,69 +66,134 @@ class tags {
   template<typename T>
   auto with(std::string_view name, T&& value) && -> tags&&;
 
-  auto data() const noexcept -> const std::unordered_map<std::string, tag_value>&;
-  auto data() noexcept -> std::unordered_map<std::string, tag_value>&;
+  ///\brief Iterate the tags, in order of name.
+  auto begin() const noexcept -> const_iterator;
+  auto end() const noexcept -> const_iterator;
+  auto size() const noexcept -> std::size_t;
   auto empty() const noexcept -> bool;
 
+  ///\brief Find the value of the tag \p name, or nullptr if there is no such tag.
+  auto find(std::string_view name) const noexcept -> const tag_value*;
+  ///\brief Number of tags named \p name: 0 or 1.
+  auto count(std::string_view name) const noexcept -> std::size_t;
+
+  ///\deprecated Iterate the tags, or use find(), instead. This will be removed in the next release.
+  [[deprecated("iterate the tags, or use find(), instead")]]
+  auto data() const noexcept -> data_view;
+
+  /**
+   * \brief Render the label fragment for these tags.
+   * \details
+   * The fragment is kept until the tags are modified.
+   */
+  void render();
+  ///\brief The rendered label fragment, or nullptr if the tags were not rendered.
+  auto fragment() const noexcept -> const label_fragment*;
+
   private:
-  std::unordered_map<std::string, tag_value> tags_;
+  // Position of the first tag with a name that is not less than name.
+  auto lower_bound_(std::string_view name) const noexcept -> const_iterator;
+  // Value of the tag name, inserting the tag if it doesn't exist.
+  auto slot_(std::string_view name) -> tag_value&;
+
+  detail::small_vector<value_type, inline_size> tags_;
+  std::shared_ptr<const label_fragment> fragment_;
 };
 
 
-inline tags::tags(std::initializer_list<std::pair<const std::string, tag_value>> init)
-: tags_(init)
-{}
+inline tags::tags(std::initializer_list<std::pair<const std::string, tag_value>> init) {
+  tags_.reserve(init.size());
+  for (const auto& e : init) {
+    const auto pos = lower_bound_(e.first);
+    if (pos == end() || pos->first != e.first) tags_.emplace(pos, e.first, e.second);
+  }
+}
 
 template<typename T>
 inline auto tags::with(std::string_view name, T&& value) & -> tags& {
+  fragment_.reset();
+  tag_value& v = slot_(name);
   if constexpr(std::is_same_v<bool, std::decay_t<T>>) {
-    auto emplace_result = tags_.emplace(
-        std::piecewise_construct,
-        std::forward_as_tuple(name.begin(), name.end()),
-        std::forward_as_tuple(std::in_place_type<bool>, value));
-    if (!std::get<1>(emplace_result))
-      std::get<0>(emplace_result)->second.template emplace<bool>(value);
-  } else if constexpr(std::is_integral_v<T>) {
-    auto emplace_result = tags_.emplace(
-        std::piecewise_construct,
-        std::forward_as_tuple(name.begin(), name.end()),
-        std::forward_as_tuple(std::in_place_type<std::int64_t>, value));
-    if (!std::get<1>(emplace_result))
-      std::get<0>(emplace_result)->second.template emplace<std::int64_t>(value);
-  } else if constexpr(std::is_floating_point_v<T>) {
-    auto emplace_result = tags_.emplace(
-        std::piecewise_construct,
-        std::forward_as_tuple(name.begin(), name.end()),
-        std::forward_as_tuple(std::in_place_type<double>, value));
-    if (!std::get<1>(emplace_result))
-      std::get<0>(emplace_result)->second.template emplace<double>(value);
+    v.template emplace<bool>(value);
+  } else if constexpr(std::is_integral_v<std::decay_t<T>>) {
+    v.template emplace<std::int64_t>(value);
+  } else if constexpr(std::is_floating_point_v<std::decay_t<T>>) {
+    v.template emplace<double>(value);
   } else {
-    auto emplace_result = tags_.emplace(
-        std::piecewise_construct,
-        std::forward_as_tuple(name.begin(), name.end()),
-        std::forward_as_tuple(std::in_place_type<std::string>, value));
-    if (!std::get<1>(emplace_result))
-      std::get<0>(emplace_result)->second.template emplace<std::string>(value);
+    v.template emplace<std::string>(std::forward<T>(value));
   }
   return *this;
 }
 
 template<typename T>
 auto tags::with(std::string_view name, T&& value) && -> tags&& {
-  with(std::move(name), std::move(value));
+  with(std::move(name), std::forward<T>(value));
   return std::move(*this);
 }
 
-inline auto tags::data() const noexcept -> const std::unordered_map<std::string, tag_value>& {
-  return tags_;
+inline auto tags::begin() const noexcept -> const_iterator {
+  return tags_.begin();
 }
 
-inline auto tags::data() noexcept -> std::unordered_map<std::string, tag_value>& {
-  return tags_;
+inline auto tags::end() const noexcept -> const_iterator {
+  return tags_.end();
+}
+
+inline auto tags::size() const noexcept -> std::size_t {
+  return tags_.size();
 }
 
 inline auto tags::empty() const noexcept -> bool {
-  return data().empty();
+  return tags_.empty();
+}
+
+inline auto tags::find(std::string_view name) const noexcept -> const tag_value* {
+  const auto pos = lower_bound_(name);
+  if (pos == end() || pos->first != name) return nullptr;
+  return &pos->second;
+}
+
+inline auto tags::count(std::string_view name) const noexcept -> std::size_t {
+  return find(name) == nullptr ? 0u : 1u;
+}
+
+inline auto tags::data() const noexcept -> data_view {
+  return data_view(*this);
+}
+
+inline void tags::render() {
+  fragment_ = std::make_shared<const label_fragment>(*this);
+}
+
+inline auto tags::fragment() const noexcept -> const label_fragment* {
+  return fragment_.get();
+}
+
+inline auto tags::data_view::find(std::string_view name) const noexcept -> const_iterator {
+  const auto pos = t_.lower_bound_(name);
+  if (pos == end() || pos->first != name) return end();
+  return pos;
+}
+
+inline auto tags::data_view::at(std::string_view name) const -> const tag_value& {
+  const tag_value* v = t_.find(name);
+  if (v == nullptr) throw std::out_of_range("tags: no such tag");
+  return *v;
+}
+
+inline auto tags::lower_bound_(std::string_view name) const noexcept -> const_iterator {
+  return std::lower_bound(
+      begin(), end(), name,
+      [](const value_type& e, std::string_view n) {
+        return std::string_view(e.first) < n;
+      });
+}
+
+inline auto tags::slot_(std::string_view name) -> tag_value& {
+  const auto pos = lower_bound_(name);
+  if (pos != end() && pos->first == name)
+    return tags_[pos - begin()].second;
+  return tags_.emplace(pos, std::piecewise_construct, std::forward_as_tuple(name), std::forward_as_tuple()).second;
 }
 
 
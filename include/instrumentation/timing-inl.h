@@ -59,11 +59,32 @@ timing_vector<LabelTypes...>::timing_vector(
     metric_name name,
     std::array<std::string, sizeof...(LabelTypes)> labels,
     std::vector<duration> buckets,
+    std::string description)
+: timing_vector(e, std::move(name), std::move(labels), std::move(buckets), timing_layout::compact, std::move(description))
+{}
+
+template<typename... LabelTypes>
+timing_vector<LabelTypes...>::timing_vector(
+    metric_name name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    std::vector<duration> buckets,
+    timing_layout layout,
+    std::string description)
+: timing_vector(engine::global(), std::move(name), std::move(labels), std::move(buckets), layout, std::move(description))
+{}
+
+template<typename... LabelTypes>
+timing_vector<LabelTypes...>::timing_vector(
+    engine& e,
+    metric_name name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    std::vector<duration> buckets,
+    timing_layout layout,
     std::string description) {
   const auto raw_metric = e.get_metric(
       std::move(name),
-      [&labels, &description, &buckets]() {
-        return group_type::make(std::move(labels), std::move(description), std::move(buckets));
+      [&labels, &description, &buckets, layout]() {
+        return group_type::make(std::move(labels), std::move(description), std::move(buckets), layout);
       });
   // We silently allow for a null impl if the metric doesn't match type.
   impl_ = std::dynamic_pointer_cast<group_type>(raw_metric);
@@ -106,14 +127,143 @@ timing_vector<LabelTypes...>::timing_vector(
 {}
 
 template<typename... LabelTypes>
-auto timing_vector<LabelTypes...>::labels(const LabelTypes&... values) const -> timing {
+timing_vector<LabelTypes...>::timing_vector(
+    std::string_view name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    std::vector<duration> buckets,
+    timing_layout layout,
+    std::string description)
+: timing_vector(metric_name(name), std::move(labels), std::move(buckets), layout, std::move(description))
+{}
+
+template<typename... LabelTypes>
+timing_vector<LabelTypes...>::timing_vector(
+    engine& e,
+    std::string_view name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    std::vector<duration> buckets,
+    timing_layout layout,
+    std::string description)
+: timing_vector(e, metric_name(name), std::move(labels), std::move(buckets), layout, std::move(description))
+{}
+
+template<typename... LabelTypes>
+timing_vector<LabelTypes...>::timing_vector(
+    metric_name name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    log_linear_buckets buckets,
+    std::string description)
+: timing_vector(std::move(name), std::move(labels), std::move(buckets), timing_layout::compact, std::move(description))
+{}
+
+template<typename... LabelTypes>
+timing_vector<LabelTypes...>::timing_vector(
+    engine& e,
+    metric_name name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    log_linear_buckets buckets,
+    std::string description)
+: timing_vector(e, std::move(name), std::move(labels), std::move(buckets), timing_layout::compact, std::move(description))
+{}
+
+template<typename... LabelTypes>
+timing_vector<LabelTypes...>::timing_vector(
+    metric_name name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    log_linear_buckets buckets,
+    timing_layout layout,
+    std::string description)
+: timing_vector(engine::global(), std::move(name), std::move(labels), std::move(buckets), layout, std::move(description))
+{}
+
+template<typename... LabelTypes>
+timing_vector<LabelTypes...>::timing_vector(
+    engine& e,
+    metric_name name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    log_linear_buckets buckets,
+    timing_layout layout,
+    std::string description) {
+  const auto raw_metric = e.get_metric(
+      std::move(name),
+      [&labels, &description, &buckets, layout]() {
+        return group_type::make(std::move(labels), std::move(description), std::move(buckets), layout);
+      });
+  // We silently allow for a null impl if the metric doesn't match type.
+  impl_ = std::dynamic_pointer_cast<group_type>(raw_metric);
+}
+
+template<typename... LabelTypes>
+timing_vector<LabelTypes...>::timing_vector(
+    std::string_view name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    log_linear_buckets buckets,
+    std::string description)
+: timing_vector(metric_name(name), std::move(labels), std::move(buckets), std::move(description))
+{}
+
+template<typename... LabelTypes>
+timing_vector<LabelTypes...>::timing_vector(
+    engine& e,
+    std::string_view name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    log_linear_buckets buckets,
+    std::string description)
+: timing_vector(e, metric_name(name), std::move(labels), std::move(buckets), std::move(description))
+{}
+
+template<typename... LabelTypes>
+timing_vector<LabelTypes...>::timing_vector(
+    std::string_view name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    log_linear_buckets buckets,
+    timing_layout layout,
+    std::string description)
+: timing_vector(metric_name(name), std::move(labels), std::move(buckets), layout, std::move(description))
+{}
+
+template<typename... LabelTypes>
+timing_vector<LabelTypes...>::timing_vector(
+    engine& e,
+    std::string_view name,
+    std::array<std::string, sizeof...(LabelTypes)> labels,
+    log_linear_buckets buckets,
+    timing_layout layout,
+    std::string description)
+: timing_vector(e, metric_name(name), std::move(labels), std::move(buckets), layout, std::move(description))
+{}
+
+template<typename... LabelTypes>
+auto timing_vector<LabelTypes...>::labels(detail::label_arg_t<LabelTypes>... values) const -> timing {
   timing result;
   if (impl_ == nullptr) return result;
 
-  result.impl_ = impl_->get(std::make_tuple(values...));
+  result.impl_ = impl_->get(values...);
   return result;
 }
 
+template<typename... LabelTypes>
+void timing_vector<LabelTypes...>::expire(expiry policy) const {
+  if (impl_ != nullptr) impl_->expire(std::move(policy));
+}
+
+template<typename... LabelTypes>
+auto timing_vector<LabelTypes...>::expired() const noexcept -> std::uint64_t {
+  if (impl_ == nullptr) return 0;
+  return impl_->expired();
+}
+
+template<typename... LabelTypes>
+void timing_vector<LabelTypes...>::limit_series(std::size_t n) const noexcept {
+  if (impl_ != nullptr) impl_->limit_series(n);
+}
+
+template<typename... LabelTypes>
+auto timing_vector<LabelTypes...>::dropped() const noexcept -> std::uint64_t {
+  if (impl_ == nullptr) return 0;
+  return impl_->dropped();
+}
+
 template<typename... LabelTypes>
 timing_vector<LabelTypes...>::operator bool() const noexcept {
   return impl_ != nullptr;
@@ -136,6 +286,10 @@ inline void timing_impl::collect(const metric_name& name, const tags& tags, coll
   return c.visit(name, tags, tmp);
 }
 
+inline auto timing_impl::generation() const noexcept -> const generation_marker& {
+  return generation_;
+}
+
 inline auto operator==(const timing_impl::histogram_entry& x, const timing_impl::histogram_entry& y) noexcept -> bool {
   return x.le == y.le && x.bucket_count == y.bucket_count;
 }
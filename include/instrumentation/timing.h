@@ -2,17 +2,82 @@
 #define INSTRUMENTATION_TIMING_H
 
 #include <instrumentation/fwd.h>
+#include <instrumentation/expiry.h>
 #include <instrumentation/detail/metric_group.h>
+#include <instrumentation/detail/stripe.h>
 #include <array>
 #include <atomic>
 #include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <iosfwd>
 #include <memory>
 #include <string>
 #include <tuple>
 #include <vector>
 
+namespace instrumentation {
+
+
+///\brief Memory layout of the bucket counters of a timing.
+enum class timing_layout {
+  ///\brief Counters are packed together, using the least memory.
+  compact,
+  /**
+   * \brief Each counter has a cache line to itself.
+   * \details
+   * Concurrent updates to neighbouring buckets don't false-share,
+   * at the cost of a cache line per bucket.
+   */
+  padded,
+  /**
+   * \brief Each thread stripe has a private copy of the counters.
+   * \details
+   * Threads record into the copy selected by their stripe index,
+   * so concurrent updates, even to the same bucket, don't contend.
+   * Reading the histogram sums the copies.
+   *
+   * The number of copies is based on the hardware concurrency.
+   */
+  sharded,
+};
+
+
+/**
+ * \brief Log-linear bucket layout for a timing.
+ * \details
+ * Log-linear buckets split each power-of-two range of durations into
+ * `2^precision` equally sized buckets, like HDR histograms.
+ * The bucket of a duration is computed from its leading bit and
+ * the `precision` bits after it, in constant time,
+ * instead of searching the thresholds.
+ *
+ * The relative width of a bucket is at most `2^-precision`.
+ */
+struct log_linear_buckets {
+  using duration = std::chrono::high_resolution_clock::duration;
+
+  /**
+   * \brief Describe log-linear buckets.
+   * \param resolution Width of the smallest buckets.
+   *   This is rounded down to a power of two clock ticks.
+   * \param max Durations above this are counted in the `+Inf` bucket.
+   * \param precision Number of bits after the leading bit used to select a bucket.
+   */
+  log_linear_buckets(duration resolution, duration max, unsigned int precision) noexcept
+  : resolution(resolution),
+    max(max),
+    precision(precision)
+  {}
+
+  duration resolution;
+  duration max;
+  unsigned int precision;
+};
+
+
+} /* namespace instrumentation */
+
 namespace instrumentation::detail {
 
 
@@ -29,31 +94,62 @@ class timing_impl
   };
 
   private:
-  struct bucket {
-    duration::rep le;
-    std::atomic<std::uint64_t> v{ 0u };
-  };
+  using counter_type = std::atomic<std::uint64_t>;
 
-  struct search_comparison;
+  static inline constexpr std::size_t counters_per_line = cache_line_size / sizeof(counter_type);
 
-  using bucket_vector = std::vector<bucket>;
+  struct alignas(cache_line_size) counter_line {
+    counter_type v[counters_per_line] = {};
+  };
 
   public:
   instrumentation_export_
-  explicit timing_impl(const std::vector<duration>& thresholds);
+  explicit timing_impl(const std::vector<duration>& thresholds, timing_layout layout = timing_layout::compact);
+  instrumentation_export_
+  explicit timing_impl(const log_linear_buckets& buckets, timing_layout layout = timing_layout::compact);
 
   instrumentation_export_
   void inc(duration d, std::uint64_t v = 1) noexcept;
+  ///\brief Number of buckets, including the bucket for durations past the last threshold.
+  instrumentation_export_
+  auto bucket_count() const noexcept -> std::size_t;
+  ///\brief Index of the bucket that holds \p d.
+  instrumentation_export_
+  auto bucket_index(duration d) const noexcept -> std::size_t;
+  ///\brief Add \p v to the bucket at \p idx.
+  instrumentation_export_
+  void inc_bucket(std::size_t idx, std::uint64_t v) noexcept;
   instrumentation_export_
   auto get_histogram() const -> std::tuple<std::vector<histogram_entry>, std::uint64_t>;
   void collect(const metric_name& name, const tags& tags, collector& c);
+  ///\brief Generation in which this metric was last modified.
+  auto generation() const noexcept -> const generation_marker&;
 
   instrumentation_export_
   static auto default_buckets() -> std::vector<duration>;
 
   private:
-  bucket_vector v_;
-  std::atomic<std::uint64_t> large_v_{ 0u };
+  void init_counters_(timing_layout layout);
+  auto log_linear_index_(duration d) const noexcept -> std::size_t;
+  auto counter_(std::size_t shard, std::size_t idx) noexcept -> counter_type&;
+  auto counter_(std::size_t shard, std::size_t idx) const noexcept -> const counter_type&;
+  auto sum_(std::size_t idx) const noexcept -> std::uint64_t;
+
+  ///\brief Bucket thresholds, read-only after construction.
+  std::vector<duration::rep> le_;
+  ///\brief Bucket counters, one per threshold plus one for larger durations.
+  std::unique_ptr<counter_line[]> counters_;
+  ///\brief Distance between the counters of adjacent buckets.
+  std::size_t stride_;
+  ///\brief Distance between the counters of adjacent shards.
+  std::size_t shard_stride_;
+  ///\brief Number of shards minus one; shards are a power of two.
+  std::size_t shard_mask_;
+  ///\brief If set, buckets are log-linear and the bucket index is computed instead of searched.
+  bool log_linear_ = false;
+  unsigned int ll_unit_shift_ = 0;
+  unsigned int ll_precision_ = 0;
+  generation_marker generation_;
 };
 
 auto operator==(const timing_impl::histogram_entry& x, const timing_impl::histogram_entry& y) noexcept -> bool;
@@ -70,6 +166,7 @@ namespace instrumentation {
 
 class timing {
   friend detail::timing_impl;
+  friend timing_batch;
   template<typename... LabelTypes> friend class timing_vector;
 
   public:
@@ -105,13 +202,34 @@ class timing_vector {
   timing_vector(engine& e, metric_name name, std::array<std::string, sizeof...(LabelTypes)> labels, std::string description = "");
   timing_vector(metric_name name, std::array<std::string, sizeof...(LabelTypes)> labels, std::vector<duration> buckets, std::string description);
   timing_vector(engine& e, metric_name name, std::array<std::string, sizeof...(LabelTypes)> labels, std::vector<duration> buckets, std::string description);
+  timing_vector(metric_name name, std::array<std::string, sizeof...(LabelTypes)> labels, std::vector<duration> buckets, timing_layout layout, std::string description);
+  timing_vector(engine& e, metric_name name, std::array<std::string, sizeof...(LabelTypes)> labels, std::vector<duration> buckets, timing_layout layout, std::string description);
+  timing_vector(metric_name name, std::array<std::string, sizeof...(LabelTypes)> labels, log_linear_buckets buckets, std::string description);
+  timing_vector(engine& e, metric_name name, std::array<std::string, sizeof...(LabelTypes)> labels, log_linear_buckets buckets, std::string description);
+  timing_vector(metric_name name, std::array<std::string, sizeof...(LabelTypes)> labels, log_linear_buckets buckets, timing_layout layout, std::string description);
+  timing_vector(engine& e, metric_name name, std::array<std::string, sizeof...(LabelTypes)> labels, log_linear_buckets buckets, timing_layout layout, std::string description);
 
   timing_vector(std::string_view name, std::array<std::string, sizeof...(LabelTypes)> labels, std::string description = "");
   timing_vector(engine& e, std::string_view name, std::array<std::string, sizeof...(LabelTypes)> labels, std::string description = "");
   timing_vector(std::string_view name, std::array<std::string, sizeof...(LabelTypes)> labels, std::vector<duration> buckets, std::string description);
   timing_vector(engine& e, std::string_view name, std::array<std::string, sizeof...(LabelTypes)> labels, std::vector<duration> buckets, std::string description);
-
-  auto labels(const LabelTypes&... values) const -> timing;
+  timing_vector(std::string_view name, std::array<std::string, sizeof...(LabelTypes)> labels, std::vector<duration> buckets, timing_layout layout, std::string description);
+  timing_vector(engine& e, std::string_view name, std::array<std::string, sizeof...(LabelTypes)> labels, std::vector<duration> buckets, timing_layout layout, std::string description);
+  timing_vector(std::string_view name, std::array<std::string, sizeof...(LabelTypes)> labels, log_linear_buckets buckets, std::string description);
+  timing_vector(engine& e, std::string_view name, std::array<std::string, sizeof...(LabelTypes)> labels, log_linear_buckets buckets, std::string description);
+  timing_vector(std::string_view name, std::array<std::string, sizeof...(LabelTypes)> labels, log_linear_buckets buckets, timing_layout layout, std::string description);
+  timing_vector(engine& e, std::string_view name, std::array<std::string, sizeof...(LabelTypes)> labels, log_linear_buckets buckets, timing_layout layout, std::string description);
+
+  auto labels(detail::label_arg_t<LabelTypes>... values) const -> timing;
+
+  ///\brief Set the policy for removing idle series.
+  void expire(expiry policy) const;
+  ///\brief Number of series removed by the expiry policy.
+  auto expired() const noexcept -> std::uint64_t;
+  ///\brief Limit the number of series, directing further label sets to a shared overflow series.
+  void limit_series(std::size_t n) const noexcept;
+  ///\brief Number of lookups that were directed to the overflow series.
+  auto dropped() const noexcept -> std::uint64_t;
 
   explicit operator bool() const noexcept;
   auto operator!() const noexcept -> bool;
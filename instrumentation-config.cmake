@@ -1,2 +1,4 @@
 get_filename_component(SELF_DIR "${CMAKE_CURRENT_LIST_FILE}" PATH)
+# Static builds link against zlib, if it was found when the library was built.
+find_package(ZLIB QUIET)
 include(${SELF_DIR}/instrumentation.cmake)
@@ -1,4 +1,22 @@
 #include <instrumentation/engine.h>
+#include <instrumentation/detail/generation.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace instrumentation::detail {
+
+
+std::atomic<std::uint64_t> current_generation{ 1u };
+
+
+} /* namespace instrumentation::detail */
 
 namespace instrumentation {
 
@@ -8,11 +26,74 @@ auto engine::global() -> engine& {
   return impl_;
 }
 
-void engine::collect(collector& c) const {
-  std::shared_lock<std::shared_mutex> lck{ mtx_ };
+auto engine::snapshot_() const -> group_snapshot {
+  group_snapshot groups;
 
+  std::shared_lock<std::shared_mutex> lck{ mtx_ };
+  groups.reserve(metrics_.size());
   for (const auto& metric_pair : metrics_)
-    metric_pair.second->collect(metric_pair.first, c);
+    groups.emplace_back(&metric_pair.first, metric_pair.second);
+  return groups;
+}
+
+void engine::collect(collector& c) const {
+  // Collectors are invoked without holding the lock,
+  // so a slow collector doesn't block registration of new metrics.
+  for (const auto& [name, group] : snapshot_())
+    group->collect(*name, c);
+}
+
+void engine::collect_changed(collector& c, cursor& cur) const {
+  // Series modified from now on are marked with a later generation.
+  // Series marked with the current generation may have been modified after they were visited,
+  // so the next call includes the current generation.
+  const std::uint64_t gen = detail::current_generation.fetch_add(1u, std::memory_order_relaxed);
+
+  for (const auto& [name, group] : snapshot_())
+    group->collect_changed(*name, c, cur.since_);
+
+  cur.since_ = gen;
+}
+
+void engine::collect_parallel(const std::vector<collector*>& collectors, unsigned int threads) const {
+  const group_snapshot groups = snapshot_();
+
+  const std::size_t chunks = collectors.size();
+  std::atomic<std::size_t> next_chunk{ 0u };
+  std::mutex error_mtx;
+  std::exception_ptr error;
+
+  const auto worker =
+      [&]() {
+        for (std::size_t i = next_chunk.fetch_add(1u); i < chunks; i = next_chunk.fetch_add(1u)) {
+          const std::size_t b = i * groups.size() / chunks;
+          const std::size_t e = (i + 1u) * groups.size() / chunks;
+
+          try {
+            for (std::size_t j = b; j < e; ++j)
+              groups[j].second->collect(*groups[j].first, *collectors[i]);
+          } catch (...) {
+            std::lock_guard<std::mutex> error_lck{ error_mtx };
+            if (error == nullptr) error = std::current_exception();
+          }
+        }
+      };
+
+  std::vector<std::thread> pool;
+  // The calling thread is one of the workers.
+  const std::size_t wanted_threads = std::min<std::size_t>(std::max(threads, 1u), chunks);
+  const std::size_t extra_threads = (wanted_threads == 0u ? 0u : wanted_threads - 1u);
+  pool.reserve(extra_threads);
+  try {
+    while (pool.size() < extra_threads) pool.emplace_back(worker);
+  } catch (const std::system_error&) {
+    // Continue with the threads we have: the calling thread picks up the remaining chunks.
+  }
+
+  worker();
+  for (auto& t : pool) t.join();
+
+  if (error != nullptr) std::rethrow_exception(error);
 }
 
 
@@ -0,0 +1,97 @@
+#include "gzip.h"
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+
+#ifdef INSTRUMENTATION_HAVE_ZLIB
+# define ZLIB_CONST
+# include <zlib.h>
+#endif
+
+namespace instrumentation::detail {
+
+
+#ifdef INSTRUMENTATION_HAVE_ZLIB
+
+struct gzip_writer::state {
+  // Scrape output is compressed while the scrape is in progress, so favour speed.
+  // Exposition text is very repetitive, so the fastest level still compresses well.
+  static constexpr int level = Z_BEST_SPEED;
+  // Window bits, plus 16 to produce a gzip header and trailer instead of a zlib one.
+  static constexpr int window_bits = 15 + 16;
+  static constexpr int mem_level = 8;
+  // Space made available for output in each deflate call.
+  static constexpr std::size_t output_step = 32u * 1024u;
+
+  state() {
+    if (deflateInit2(&strm, level, Z_DEFLATED, window_bits, mem_level, Z_DEFAULT_STRATEGY) != Z_OK)
+      throw std::runtime_error("gzip: unable to initialize compressor");
+  }
+
+  ~state() noexcept {
+    deflateEnd(&strm);
+  }
+
+  // Run deflate until all input is consumed, or until the stream ends if flush is Z_FINISH.
+  void deflate_into(std::string& out, int flush) {
+    for (;;) {
+      const std::size_t old_size = out.size();
+      const std::size_t avail = output_step;
+      out.resize(old_size + avail);
+      strm.next_out = reinterpret_cast<Bytef*>(out.data() + old_size);
+      strm.avail_out = static_cast<uInt>(avail);
+
+      const int rv = deflate(&strm, flush);
+      out.resize(old_size + (avail - strm.avail_out));
+      if (rv == Z_STREAM_END) return;
+      if (rv != Z_OK && rv != Z_BUF_ERROR) throw std::runtime_error("gzip: compression failed");
+      if (flush != Z_FINISH && strm.avail_in == 0u && strm.avail_out != 0u) return;
+    }
+  }
+
+  z_stream strm{};
+};
+
+gzip_writer::gzip_writer(std::string& out)
+: out_(out),
+  state_(std::make_unique<state>())
+{}
+
+void gzip_writer::write(std::string_view in) {
+  // avail_in is an unsigned int, so very large input is handed over in pieces.
+  constexpr std::size_t max_in = 1u << 30;
+  while (!in.empty()) {
+    const auto n = std::min(in.size(), max_in);
+    state_->strm.next_in = reinterpret_cast<const Bytef*>(in.data());
+    state_->strm.avail_in = static_cast<uInt>(n);
+    state_->deflate_into(out_, Z_NO_FLUSH);
+    in.remove_prefix(n);
+  }
+}
+
+void gzip_writer::finish() {
+  state_->strm.next_in = nullptr;
+  state_->strm.avail_in = 0;
+  state_->deflate_into(out_, Z_FINISH);
+}
+
+#else
+
+struct gzip_writer::state {};
+
+gzip_writer::gzip_writer(std::string& out)
+: out_(out)
+{
+  throw std::logic_error("gzip: instrumentation was built without zlib");
+}
+
+void gzip_writer::write([[maybe_unused]] std::string_view in) {}
+
+void gzip_writer::finish() {}
+
+#endif
+
+gzip_writer::~gzip_writer() noexcept = default;
+
+
+} /* namespace instrumentation::detail */
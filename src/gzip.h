@@ -0,0 +1,57 @@
+#ifndef INSTRUMENTATION_SRC_GZIP_H
+#define INSTRUMENTATION_SRC_GZIP_H
+
+/*
+ * Incremental gzip compression, for the compressed exporters.
+ */
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace instrumentation::detail {
+
+
+///\brief Test if the library was built with gzip support.
+constexpr auto gzip_supported() noexcept -> bool {
+#ifdef INSTRUMENTATION_HAVE_ZLIB
+  return true;
+#else
+  return false;
+#endif
+}
+
+
+/**
+ * \brief Compresses data into a gzip stream, a piece at a time.
+ * \details
+ * Compressed output is appended to a string.
+ * Input is compressed as it is written, so the uncompressed data never has to be held in full.
+ */
+class gzip_writer {
+  public:
+  /**
+   * \brief Create a writer appending to \p out.
+   * \throw std::logic_error if the library was built without gzip support.
+   */
+  explicit gzip_writer(std::string& out);
+  gzip_writer(const gzip_writer&) = delete;
+  auto operator=(const gzip_writer&) -> gzip_writer& = delete;
+  ~gzip_writer() noexcept;
+
+  ///\brief Compress \p in.
+  void write(std::string_view in);
+  ///\brief Complete the gzip stream. Nothing may be written afterwards.
+  void finish();
+
+  private:
+  struct state;
+
+  std::string& out_;
+  std::unique_ptr<state> state_;
+};
+
+
+} /* namespace instrumentation::detail */
+
+#endif /* INSTRUMENTATION_SRC_GZIP_H */
@@ -0,0 +1,525 @@
+#include <instrumentation/http.h>
+#include <instrumentation/prometheus.h>
+#include "posix_socket.h"
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace instrumentation {
+namespace {
+
+
+using detail::fd_handle;
+using detail::throw_errno;
+
+
+// Longest request head that is accepted.
+constexpr std::size_t max_request_size = 16u * 1024u;
+// Number of bytes read from a socket at a time.
+constexpr std::size_t read_size = 4096u;
+
+
+/*
+ * A rendered response.
+ *
+ * The head holds the status line and headers, except for the Connection header
+ * and the blank line that ends the headers, since those depend on the request.
+ */
+struct response {
+  std::string head;
+  std::string body;
+  std::chrono::steady_clock::time_point rendered;
+};
+
+enum format : std::size_t { text_format, protobuf_format, num_formats };
+
+
+struct request {
+  std::string_view method;
+  std::string_view target;
+  bool keep_alive = true;
+  bool protobuf = false;
+  bool gzip = false;
+  bool has_body = false;
+};
+
+
+auto iequals(std::string_view x, std::string_view y) noexcept -> bool {
+  if (x.size() != y.size()) return false;
+  for (std::size_t i = 0; i < x.size(); ++i) {
+    const auto lower = [](char c) { return c >= 'A' && c <= 'Z' ? char(c - 'A' + 'a') : c; };
+    if (lower(x[i]) != lower(y[i])) return false;
+  }
+  return true;
+}
+
+auto trim(std::string_view s) noexcept -> std::string_view {
+  while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+  while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+  return s;
+}
+
+// Test if the comma separated list s contains token.
+// Any parameters of the elements, such as a quality value, are ignored.
+auto has_token(std::string_view s, std::string_view token) noexcept -> bool {
+  while (!s.empty()) {
+    const auto comma = s.find(',');
+    const std::string_view elem = s.substr(0, comma);
+    if (iequals(trim(elem.substr(0, elem.find(';'))), token)) return true;
+    s.remove_prefix(comma == std::string_view::npos ? s.size() : comma + 1u);
+  }
+  return false;
+}
+
+// Remove and return the first line of s.
+auto next_line(std::string_view& s) noexcept -> std::string_view {
+  const auto eol = s.find("\r\n");
+  const auto line = s.substr(0, eol);
+  s.remove_prefix(eol == std::string_view::npos ? s.size() : eol + 2u);
+  return line;
+}
+
+// Parse a request head, excluding the blank line that ends it.
+auto parse_request(std::string_view head) -> std::optional<request> {
+  request r;
+
+  const std::string_view line = next_line(head);
+  const auto sp1 = line.find(' ');
+  const auto sp2 = line.rfind(' ');
+  if (sp1 == std::string_view::npos || sp1 == sp2) return std::nullopt;
+  r.method = line.substr(0, sp1);
+  r.target = line.substr(sp1 + 1u, sp2 - sp1 - 1u);
+  const std::string_view version = line.substr(sp2 + 1u);
+  if (version == "HTTP/1.1")
+    r.keep_alive = true;
+  else if (version == "HTTP/1.0")
+    r.keep_alive = false;
+  else
+    return std::nullopt;
+
+  while (!head.empty()) {
+    const std::string_view header = next_line(head);
+    const auto colon = header.find(':');
+    if (colon == std::string_view::npos) return std::nullopt;
+    const std::string_view name = header.substr(0, colon);
+    const std::string_view value = trim(header.substr(colon + 1u));
+
+    if (iequals(name, "connection")) {
+      if (has_token(value, "close"))
+        r.keep_alive = false;
+      else if (has_token(value, "keep-alive"))
+        r.keep_alive = true;
+    } else if (iequals(name, "accept")) {
+      r.protobuf = has_token(value, "application/vnd.google.protobuf");
+    } else if (iequals(name, "accept-encoding")) {
+      r.gzip = has_token(value, "gzip");
+    } else if (iequals(name, "content-length")) {
+      r.has_body = (value != "0");
+    } else if (iequals(name, "transfer-encoding")) {
+      r.has_body = true;
+    }
+  }
+  return r;
+}
+
+auto error_response(std::string_view status, std::string_view extra_headers = std::string_view()) -> std::shared_ptr<const response> {
+  auto r = std::make_shared<response>();
+  r->body.append(status).append("\n");
+  r->head.append("HTTP/1.1 ").append(status).append("\r\n")
+      .append("Content-Type: text/plain\r\n")
+      .append("Content-Length: ").append(std::to_string(r->body.size())).append("\r\n")
+      .append(extra_headers);
+  return r;
+}
+
+
+struct connection {
+  fd_handle fd;
+  // Received bytes that are not yet processed.
+  std::string in;
+  // The peer won't send more data.
+  bool eof = false;
+  // Events the connection is registered for.
+  std::uint32_t events = EPOLLIN;
+
+  // Response being sent, or nullptr if there is none.
+  std::shared_ptr<const response> out;
+  std::string_view out_trailer;
+  bool head_only = false;
+  bool close_after = false;
+  std::size_t out_pos = 0;
+};
+
+
+} /* namespace instrumentation::<unnamed> */
+
+
+class http_exporter::impl {
+  public:
+  impl(const engine& e, fd_handle listener, std::uint16_t port, std::string unix_path, http_options opts);
+  ~impl() noexcept;
+
+  auto port() const noexcept -> std::uint16_t { return port_; }
+
+  private:
+  void run_() noexcept;
+  void accept_();
+  // These return false if the connection must be closed.
+  auto read_(connection& c) -> bool;
+  auto process_(connection& c) -> bool;
+  auto write_(connection& c) -> bool;
+  void respond_(connection& c, const request& r);
+  void set_events_(connection& c, std::uint32_t events);
+  auto metrics_(format f, bool gzip) -> std::shared_ptr<const response>;
+
+  const engine& e_;
+  const http_options opts_;
+  const std::uint16_t port_;
+  const std::string unix_path_;
+  fd_handle listener_;
+  fd_handle epoll_;
+  fd_handle wakeup_;
+  // Descriptor held in reserve, so that pending connections can be refused when we run out.
+  fd_handle spare_;
+  std::unordered_map<int, connection> connections_;
+  // Most recently rendered responses, for each format, uncompressed and compressed.
+  std::array<std::array<std::shared_ptr<response>, 2>, num_formats> cache_;
+  std::thread thread_;
+};
+
+
+http_exporter::impl::impl(const engine& e, fd_handle listener, std::uint16_t port, std::string unix_path, http_options opts)
+: e_(e),
+  opts_(std::move(opts)),
+  port_(port),
+  unix_path_(std::move(unix_path)),
+  listener_(std::move(listener)),
+  epoll_(::epoll_create1(EPOLL_CLOEXEC)),
+  wakeup_(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+  spare_(::open("/dev/null", O_RDONLY | O_CLOEXEC))
+{
+  if (epoll_.get() == -1) throw_errno("epoll_create1");
+  if (wakeup_.get() == -1) throw_errno("eventfd");
+
+  for (int fd : { listener_.get(), wakeup_.get() }) {
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if (::epoll_ctl(epoll_.get(), EPOLL_CTL_ADD, fd, &ev) == -1) throw_errno("epoll_ctl");
+  }
+
+  thread_ = std::thread(&impl::run_, this);
+}
+
+http_exporter::impl::~impl() noexcept {
+  const std::uint64_t one = 1;
+  [[maybe_unused]] const auto rv = ::write(wakeup_.get(), &one, sizeof(one));
+  thread_.join();
+
+  if (!unix_path_.empty()) ::unlink(unix_path_.c_str());
+}
+
+void http_exporter::impl::run_() noexcept {
+  std::array<epoll_event, 64> events;
+
+  for (;;) {
+    const int n = ::epoll_wait(epoll_.get(), events.data(), int(events.size()), -1);
+    if (n == -1) {
+      if (errno == EINTR) continue;
+      return;
+    }
+
+    for (int i = 0; i < n; ++i) {
+      const int fd = events[i].data.fd;
+      if (fd == wakeup_.get()) return;
+
+      if (fd == listener_.get()) {
+        try {
+          accept_();
+        } catch (...) {
+          // Connections that can't be allocated are dropped.
+        }
+        continue;
+      }
+
+      const auto iter = connections_.find(fd);
+      if (iter == connections_.end()) continue;
+      connection& c = iter->second;
+
+      bool keep;
+      try {
+        // A connection with a pending response is only registered for writing,
+        // so errors and hangups are picked up by the write.
+        if (c.out != nullptr)
+          keep = write_(c) && process_(c);
+        else
+          keep = read_(c) && process_(c);
+      } catch (...) {
+        keep = false;
+      }
+      if (!keep) connections_.erase(iter);
+    }
+  }
+}
+
+void http_exporter::impl::accept_() {
+  for (;;) {
+    fd_handle fd(::accept4(listener_.get(), nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC));
+    if (fd.get() == -1) {
+      if (errno == EINTR) continue;
+      if ((errno == EMFILE || errno == ENFILE) && spare_.get() != -1) {
+        // The listener stays readable while connections are pending, so it would spin.
+        // Free the spare descriptor to accept the connection, close it, and take the spare back.
+        spare_.reset();
+        const int refused = ::accept4(listener_.get(), nullptr, nullptr, SOCK_CLOEXEC);
+        if (refused != -1) ::close(refused);
+        spare_.reset(::open("/dev/null", O_RDONLY | O_CLOEXEC));
+        if (refused == -1) return;
+        continue;
+      }
+      return;
+    }
+
+    // Responses are written in one go, so there's no point in delaying partial packets.
+    // This fails harmlessly on unix domain sockets.
+    const int one = 1;
+    ::setsockopt(fd.get(), IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd.get();
+    if (::epoll_ctl(epoll_.get(), EPOLL_CTL_ADD, fd.get(), &ev) == -1) continue;
+
+    const int raw_fd = fd.get();
+    connections_[raw_fd].fd = std::move(fd);
+  }
+}
+
+auto http_exporter::impl::read_(connection& c) -> bool {
+  for (;;) {
+    const auto old_size = c.in.size();
+    c.in.resize(old_size + read_size);
+    const auto rlen = ::recv(c.fd.get(), c.in.data() + old_size, read_size, 0);
+    c.in.resize(old_size + (rlen > 0 ? std::size_t(rlen) : 0u));
+
+    if (rlen > 0) {
+      if (c.in.size() > max_request_size) return true;
+    } else if (rlen == 0) {
+      c.eof = true;
+      return true;
+    } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      return true;
+    } else if (errno != EINTR) {
+      return false;
+    }
+  }
+}
+
+auto http_exporter::impl::process_(connection& c) -> bool {
+  while (c.out == nullptr) {
+    const auto end = c.in.find("\r\n\r\n");
+    if (end == std::string::npos) {
+      if (c.in.size() <= max_request_size) break;
+      c.out = error_response("431 Request Header Fields Too Large");
+      c.out_trailer = "Connection: close\r\n\r\n";
+      c.head_only = false;
+      c.close_after = true;
+    } else if (const auto r = parse_request(std::string_view(c.in).substr(0, end)); !r || r->has_body) {
+      c.out = error_response("400 Bad Request");
+      c.out_trailer = "Connection: close\r\n\r\n";
+      c.head_only = false;
+      c.close_after = true;
+    } else {
+      respond_(c, *r);
+      c.in.erase(0, end + 4u);
+    }
+
+    if (!write_(c)) return false;
+  }
+
+  // While a response is pending, stop reading, so a client that doesn't read its responses can't make us buffer requests.
+  set_events_(c, c.out != nullptr ? EPOLLOUT : EPOLLIN);
+  return c.out != nullptr || !c.eof;
+}
+
+void http_exporter::impl::respond_(connection& c, const request& r) {
+  const std::string_view path = r.target.substr(0, r.target.find('?'));
+  c.head_only = (r.method == "HEAD");
+  c.close_after = !r.keep_alive;
+
+  if (r.method != "GET" && !c.head_only) {
+    c.out = error_response("405 Method Not Allowed", "Allow: GET, HEAD\r\n");
+  } else if (path != opts_.path) {
+    c.out = error_response("404 Not Found");
+  } else {
+    try {
+      c.out = metrics_(r.protobuf ? protobuf_format : text_format, r.gzip && prometheus_gzip_supported());
+    } catch (...) {
+      c.out = error_response("500 Internal Server Error");
+      c.close_after = true;
+    }
+  }
+
+  c.out_trailer = (c.close_after ? "Connection: close\r\n\r\n" : "Connection: keep-alive\r\n\r\n");
+}
+
+auto http_exporter::impl::write_(connection& c) -> bool {
+  while (c.out != nullptr) {
+    std::array<std::string_view, 3> parts{
+      c.out->head,
+      c.out_trailer,
+      (c.head_only ? std::string_view() : std::string_view(c.out->body)),
+    };
+
+    std::array<iovec, 3> iov;
+    std::size_t iovcnt = 0;
+    std::size_t skip = c.out_pos;
+    for (std::string_view part : parts) {
+      if (skip >= part.size()) {
+        skip -= part.size();
+        continue;
+      }
+      part.remove_prefix(skip);
+      skip = 0;
+      iov[iovcnt].iov_base = const_cast<char*>(part.data());
+      iov[iovcnt].iov_len = part.size();
+      ++iovcnt;
+    }
+
+    if (iovcnt == 0) {
+      c.out.reset();
+      c.out_pos = 0;
+      if (c.close_after) return false;
+      continue;
+    }
+
+    msghdr msg{};
+    msg.msg_iov = iov.data();
+    msg.msg_iovlen = iovcnt;
+    const auto wlen = ::sendmsg(c.fd.get(), &msg, MSG_NOSIGNAL);
+    if (wlen == -1) {
+      if (errno == EINTR) continue;
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    c.out_pos += std::size_t(wlen);
+  }
+  return true;
+}
+
+void http_exporter::impl::set_events_(connection& c, std::uint32_t events) {
+  if (c.events == events) return;
+
+  epoll_event ev{};
+  ev.events = events;
+  ev.data.fd = c.fd.get();
+  if (::epoll_ctl(epoll_.get(), EPOLL_CTL_MOD, c.fd.get(), &ev) == -1) throw_errno("epoll_ctl");
+  c.events = events;
+}
+
+auto http_exporter::impl::metrics_(format f, bool gzip) -> std::shared_ptr<const response> {
+  std::shared_ptr<response>& cached = cache_[f][gzip];
+  const auto now = std::chrono::steady_clock::now();
+  if (cached != nullptr && now - cached->rendered < opts_.max_age) return cached;
+
+  // Render into the buffers of the previous response, unless a connection is still sending it.
+  if (cached == nullptr || cached.use_count() != 1) cached = std::make_shared<response>();
+
+  try {
+    cached->body.clear();
+    if (f == protobuf_format && gzip)
+      collect_prometheus_protobuf_gzip(cached->body, e_);
+    else if (f == protobuf_format)
+      collect_prometheus_protobuf(cached->body, e_);
+    else if (gzip)
+      collect_prometheus_gzip(cached->body, e_);
+    else
+      collect_prometheus(cached->body, e_);
+
+    cached->head.clear();
+    cached->head.append("HTTP/1.1 200 OK\r\n")
+        .append("Content-Type: ").append(f == protobuf_format ? prometheus_protobuf_content_type : prometheus_content_type).append("\r\n")
+        .append("Content-Length: ").append(std::to_string(cached->body.size())).append("\r\n")
+        // The same URL serves each format, compressed or not, so caches must key on both headers.
+        .append("Vary: Accept, Accept-Encoding\r\n");
+    if (gzip) cached->head.append("Content-Encoding: ").append(gzip_content_encoding).append("\r\n");
+    cached->rendered = now;
+  } catch (...) {
+    cached.reset();
+    throw;
+  }
+  return cached;
+}
+
+
+auto http_exporter::tcp(const engine& e, const std::string& host, std::uint16_t port, http_options opts) -> http_exporter {
+  detail::inet_address addr = detail::make_inet_address(host, port);
+
+  fd_handle listener(::socket(addr.addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0));
+  if (listener.get() == -1) throw_errno("socket");
+  const int one = 1;
+  if (::setsockopt(listener.get(), SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) == -1) throw_errno("setsockopt");
+  if (::bind(listener.get(), addr.get(), addr.len) == -1) throw_errno("bind");
+  if (::listen(listener.get(), SOMAXCONN) == -1) throw_errno("listen");
+
+  // Find out which port was picked, if port was zero.
+  if (::getsockname(listener.get(), addr.get(), &addr.len) == -1) throw_errno("getsockname");
+  const std::uint16_t bound_port = ntohs(addr.addr.ss_family == AF_INET
+      ? reinterpret_cast<const sockaddr_in&>(addr.addr).sin_port
+      : reinterpret_cast<const sockaddr_in6&>(addr.addr).sin6_port);
+
+  return http_exporter(std::make_unique<impl>(e, std::move(listener), bound_port, std::string(), std::move(opts)));
+}
+
+auto http_exporter::unix_socket(const engine& e, const std::string& path, http_options opts) -> http_exporter {
+  sockaddr_un addr{};
+  if (path.empty() || path.size() >= sizeof(addr.sun_path))
+    throw std::invalid_argument("http_exporter: invalid unix socket path");
+  addr.sun_family = AF_UNIX;
+  std::memcpy(addr.sun_path, path.data(), path.size());
+
+  fd_handle listener(::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0));
+  if (listener.get() == -1) throw_errno("socket");
+  ::unlink(path.c_str());
+  if (::bind(listener.get(), reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == -1) throw_errno("bind");
+  if (::listen(listener.get(), SOMAXCONN) == -1) {
+    const int saved_errno = errno;
+    ::unlink(path.c_str());
+    errno = saved_errno;
+    throw_errno("listen");
+  }
+
+  return http_exporter(std::make_unique<impl>(e, std::move(listener), 0, path, std::move(opts)));
+}
+
+http_exporter::http_exporter(std::unique_ptr<impl> impl) noexcept
+: impl_(std::move(impl))
+{}
+
+http_exporter::http_exporter(http_exporter&&) noexcept = default;
+auto http_exporter::operator=(http_exporter&&) noexcept -> http_exporter& = default;
+http_exporter::~http_exporter() noexcept = default;
+
+auto http_exporter::port() const noexcept -> std::uint16_t {
+  return impl_->port();
+}
+
+
+} /* namespace instrumentation */
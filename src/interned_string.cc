@@ -0,0 +1,64 @@
+#include <instrumentation/interned_string.h>
+#include <instrumentation/detail/series_map.h>
+#include <instrumentation/detail/stripe.h>
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+
+namespace instrumentation::detail {
+namespace {
+
+
+/*
+ * Process-wide intern pool.
+ *
+ * The pool is split into shards, each with its own lock,
+ * so threads interning different strings rarely contend.
+ * Entries are never removed.
+ */
+class intern_pool {
+  public:
+  auto intern(std::string_view s, std::uint64_t hash) -> const intern_entry& {
+    shard& sh = shards_[(hash >> 32) % num_shards];
+
+    {
+      const std::shared_lock<std::shared_mutex> lck{ sh.mtx };
+      if (const auto ptr = sh.entries.find(hash, s); ptr != nullptr) return **ptr;
+    }
+
+    const std::lock_guard<std::shared_mutex> lck{ sh.mtx };
+    // Another thread may have interned the string, while we didn't hold the lock.
+    if (const auto ptr = sh.entries.find(hash, s); ptr != nullptr) return **ptr;
+
+    const intern_entry& e = sh.storage.emplace_back(intern_entry{ hash, std::string(s) });
+    sh.entries.emplace(hash, e.text, &e);
+    return e;
+  }
+
+  private:
+  static constexpr std::size_t num_shards = 16;
+
+  struct alignas(cache_line_size) shard {
+    std::shared_mutex mtx;
+    // Deque elements don't move, so the entries remain valid.
+    std::deque<intern_entry> storage;
+    series_map<std::string_view, const intern_entry*> entries;
+  };
+
+  std::array<shard, num_shards> shards_;
+};
+
+
+} /* namespace instrumentation::detail::<unnamed> */
+
+
+auto intern(std::string_view s, std::uint64_t hash) -> const intern_entry& {
+  // Never destroyed, so interned strings remain valid during static destruction.
+  static intern_pool* const pool = new intern_pool();
+  return pool->intern(s, hash);
+}
+
+
+} /* namespace instrumentation::detail */
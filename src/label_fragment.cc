@@ -0,0 +1,55 @@
+#include <instrumentation/label_fragment.h>
+#include <instrumentation/tags.h>
+#include "prom_text.h"
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace instrumentation {
+
+
+label_fragment::label_fragment(const tags& t) {
+  std::vector<std::pair<std::string, std::string>> tmp;
+  tmp.reserve(t.size());
+  for (const auto& e : t)
+    tmp.emplace_back(detail::prom_name(e.first), detail::prom_label_value(e.second));
+
+  // Tags are sorted by name, but sanitizing the names may change their order, or make them collide.
+  const auto by_name =
+      [](const auto& x, const auto& y) {
+        return x.first < y.first;
+      };
+  if (!std::is_sorted(tmp.begin(), tmp.end(), by_name)) std::stable_sort(tmp.begin(), tmp.end(), by_name);
+
+  offsets_.reserve(tmp.size());
+  for (std::size_t i = 0; i < tmp.size(); ++i) {
+    if (i > 0u && tmp[i].first == tmp[i - 1u].first) continue;
+
+    offsets_.push_back(text_.size());
+    text_.append(tmp[i].first).append(1, '=').append(tmp[i].second).append(1, ',');
+  }
+}
+
+auto label_fragment::locate(std::string_view name) const noexcept -> std::pair<std::size_t, std::size_t> {
+  std::size_t lo = 0, hi = offsets_.size();
+  while (lo < hi) {
+    const std::size_t mid = lo + (hi - lo) / 2u;
+    if (name_(mid) < name)
+      lo = mid + 1u;
+    else
+      hi = mid;
+  }
+
+  const std::size_t begin = (lo == offsets_.size() ? text_.size() : offsets_[lo]);
+  if (lo == offsets_.size() || name_(lo) != name) return { begin, begin };
+  return { begin, (lo + 1u == offsets_.size() ? text_.size() : offsets_[lo + 1u]) };
+}
+
+auto label_fragment::name_(std::size_t i) const noexcept -> std::string_view {
+  const std::string_view pair = std::string_view(text_).substr(offsets_[i]);
+  return pair.substr(0, pair.find('='));
+}
+
+
+} /* namespace instrumentation */
@@ -1,50 +1,51 @@
 #include <instrumentation/metric_name.h>
+#include <instrumentation/interned_string.h>
 
 namespace instrumentation {
 
 
+metric_name::metric_name(std::initializer_list<std::string_view> elements) {
+  std::string path;
+  for (const std::string_view& elem : elements) {
+    if (&elem != elements.begin()) path.append(1, '.');
+    path.append(elem);
+  }
+  *this = metric_name(std::string_view(path));
+}
+
 metric_name::metric_name(std::string_view path) {
   if (!path.empty()) {
-    for (auto pos = path.find("."); pos != std::string_view::npos; pos = path.find(".")) {
-      elements.emplace_back(path.begin(), path.begin() + pos);
-      path.remove_prefix(pos);
-      path.remove_prefix(1);
-    }
-    elements.emplace_back(path.begin(), path.end());
+    hash_ = detail::hash_bytes(path);
+    path_ = detail::intern(path, hash_).text;
   }
 }
 
 auto metric_name::with_separator(std::string_view sep) const -> std::string {
-  std::string result;
-  const auto& d = data();
+  if (sep == ".") return std::string(path_);
 
-  auto iter = d.begin();
-  if (iter != d.end()) {
-    result.append(iter->begin(), iter->end());
-
-    while (++iter != d.end()) {
-      result.append(sep.begin(), sep.end());
-      result.append(iter->begin(), iter->end());
-    }
+  std::string result;
+  result.reserve(path_.size());
+  std::string_view path = path_;
+  for (auto pos = path.find('.'); pos != std::string_view::npos; pos = path.find('.')) {
+    result.append(path.substr(0, pos)).append(sep);
+    path.remove_prefix(pos + 1u);
   }
+  result.append(path);
   return result;
 }
 
+auto metric_name::elements() const -> std::vector<std::string_view> {
+  std::vector<std::string_view> result;
+  if (path_.empty()) return result;
 
-} /* namespace instrumentation */
-
-namespace std {
-
-
-auto hash<instrumentation::metric_name>::operator()(const instrumentation::metric_name& name) const noexcept -> std::size_t {
-  const std::hash<std::string> inner_hash;
-
-  std::size_t result = 0;
-  for (const auto& elem : name.data())
-    result = 19u * result + inner_hash(elem);
-
+  std::string_view path = path_;
+  for (auto pos = path.find('.'); pos != std::string_view::npos; pos = path.find('.')) {
+    result.push_back(path.substr(0, pos));
+    path.remove_prefix(pos + 1u);
+  }
+  result.push_back(path);
   return result;
 }
 
 
-} /* namespace std */
+} /* namespace instrumentation */
@@ -0,0 +1,96 @@
+#ifndef INSTRUMENTATION_SRC_NUMBER_FORMAT_H
+#define INSTRUMENTATION_SRC_NUMBER_FORMAT_H
+
+/*
+ * Locale independent number formatting, for the exporters.
+ *
+ * Uses std::to_chars where the standard library provides it.
+ * Integer to_chars needs <charconv> (GCC 8, libc++ 7),
+ * floating point to_chars needs GCC 11 or a recent libc++,
+ * so older toolchains fall back to snprintf.
+ */
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <type_traits>
+
+#if __has_include(<charconv>)
+# include <charconv>
+# define INSTRUMENTATION_HAVE_INT_TO_CHARS 1
+#endif
+
+namespace instrumentation::detail {
+
+
+// Append the snprintf output in buf, replacing the locale specific decimal point with a dot.
+inline void append_printf_number(std::string& out, const char* buf, int len) {
+  for (int i = 0; i < len; ++i) {
+    const char c = buf[i];
+    const bool keep = (c >= '0' && c <= '9') || c == '-' || c == '+' || c == 'e' || c == 'E';
+    out.push_back(keep ? c : '.');
+  }
+}
+
+///\brief Append integer \p v.
+template<typename T>
+inline void append_integer(std::string& out, T v) {
+  static_assert(std::is_integral_v<T>);
+#ifdef INSTRUMENTATION_HAVE_INT_TO_CHARS
+  char buf[32];
+  const auto r = std::to_chars(buf, buf + sizeof(buf), v);
+  out.append(buf, r.ptr);
+#else
+  char buf[32];
+  int len;
+  if constexpr(std::is_signed_v<T>)
+    len = std::snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(v));
+  else
+    len = std::snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(v));
+  out.append(buf, len);
+#endif
+}
+
+/**
+ * \brief Append \p v, formatted as `%g` with the given precision.
+ * \details
+ * The caller must handle NaN and infinity.
+ */
+inline void append_general(std::string& out, double v, int precision) {
+  char buf[32];
+#ifdef __cpp_lib_to_chars
+  const auto r = std::to_chars(buf, buf + sizeof(buf), v, std::chars_format::general, precision);
+  out.append(buf, r.ptr);
+#else
+  const int len = std::snprintf(buf, sizeof(buf), "%.*g", precision, v);
+  append_printf_number(out, buf, len);
+#endif
+}
+
+/**
+ * \brief Append the shortest representation of \p v that reads back as \p v.
+ * \details
+ * The caller must handle NaN and infinity.
+ */
+inline void append_shortest(std::string& out, double v) {
+  char buf[32];
+#ifdef __cpp_lib_to_chars
+  const auto r = std::to_chars(buf, buf + sizeof(buf), v);
+  out.append(buf, r.ptr);
+#else
+  // 17 significant digits always read back, but fewer usually do.
+  int len = 0;
+  for (int precision = 15; precision <= 17; ++precision) {
+    len = std::snprintf(buf, sizeof(buf), "%.*g", precision, v);
+    // Formatting and parsing both use the current locale, so they agree on the decimal point.
+    if (std::strtod(buf, nullptr) == v) break;
+  }
+  append_printf_number(out, buf, len);
+#endif
+}
+
+
+} /* namespace instrumentation::detail */
+
+#endif /* INSTRUMENTATION_SRC_NUMBER_FORMAT_H */
@@ -0,0 +1,87 @@
+#ifndef INSTRUMENTATION_SRC_POSIX_SOCKET_H
+#define INSTRUMENTATION_SRC_POSIX_SOCKET_H
+
+/*
+ * Helpers for the exporters that use sockets.
+ */
+
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace instrumentation::detail {
+
+
+///\brief Throw a std::system_error for the current errno.
+[[noreturn]] inline void throw_errno(const char* what) {
+  throw std::system_error(errno, std::system_category(), what);
+}
+
+
+///\brief Owning file descriptor.
+class fd_handle {
+  public:
+  fd_handle() noexcept = default;
+  explicit fd_handle(int fd) noexcept : fd_(fd) {}
+  fd_handle(fd_handle&& y) noexcept : fd_(std::exchange(y.fd_, -1)) {}
+  fd_handle(const fd_handle&) = delete;
+
+  auto operator=(fd_handle&& y) noexcept -> fd_handle& {
+    reset(std::exchange(y.fd_, -1));
+    return *this;
+  }
+
+  ~fd_handle() noexcept { reset(); }
+
+  auto get() const noexcept -> int { return fd_; }
+
+  void reset(int fd = -1) noexcept {
+    if (fd_ != -1) ::close(fd_);
+    fd_ = fd;
+  }
+
+  private:
+  int fd_ = -1;
+};
+
+
+///\brief Socket address, and its length.
+struct inet_address {
+  sockaddr_storage addr{};
+  socklen_t len = 0;
+
+  auto get() const noexcept -> const sockaddr* { return reinterpret_cast<const sockaddr*>(&addr); }
+  auto get() noexcept -> sockaddr* { return reinterpret_cast<sockaddr*>(&addr); }
+};
+
+/**
+ * \brief Create the address for numeric IPv4 or IPv6 \p host and \p port.
+ * \throw std::invalid_argument if \p host is not a numeric address.
+ */
+inline auto make_inet_address(const std::string& host, std::uint16_t port) -> inet_address {
+  inet_address result;
+  if (auto& sin = reinterpret_cast<sockaddr_in&>(result.addr); ::inet_pton(AF_INET, host.c_str(), &sin.sin_addr) == 1) {
+    sin.sin_family = AF_INET;
+    sin.sin_port = htons(port);
+    result.len = sizeof(sin);
+  } else if (auto& sin6 = reinterpret_cast<sockaddr_in6&>(result.addr); ::inet_pton(AF_INET6, host.c_str(), &sin6.sin6_addr) == 1) {
+    sin6.sin6_family = AF_INET6;
+    sin6.sin6_port = htons(port);
+    result.len = sizeof(sin6);
+  } else {
+    throw std::invalid_argument("host must be a numeric address");
+  }
+  return result;
+}
+
+
+} /* namespace instrumentation::detail */
+
+#endif /* INSTRUMENTATION_SRC_POSIX_SOCKET_H */
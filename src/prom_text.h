@@ -0,0 +1,229 @@
+#ifndef INSTRUMENTATION_SRC_PROM_TEXT_H
+#define INSTRUMENTATION_SRC_PROM_TEXT_H
+
+/*
+ * Helpers for rendering the prometheus formats.
+ * Shared between the prometheus exporters and the label fragment.
+ */
+
+#include <instrumentation/engine.h>
+#include <instrumentation/metric_name.h>
+#include <instrumentation/tags.h>
+#include "gzip.h"
+#include "number_format.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+namespace instrumentation::detail {
+
+
+///\brief Test if \p c is allowed in a prometheus name, at the start (\p first) or further on.
+constexpr auto prom_name_char(char c, bool first) noexcept -> bool {
+  return (c >= 'a' && c <= 'z')
+      || (c >= 'A' && c <= 'Z')
+      || c == '_'
+      || c == ':'
+      || (!first && c >= '0' && c <= '9');
+}
+
+///\brief Append \p s, with characters that are not allowed in a prometheus name replaced by an underscore.
+inline void prom_append_name(std::string& out, std::string_view s) {
+  for (std::size_t i = 0; i < s.size(); ++i)
+    out.push_back(prom_name_char(s[i], i == 0u) ? s[i] : '_');
+}
+
+///\brief Replace characters that are not allowed in a prometheus name.
+inline auto prom_name(std::string_view s) -> std::string {
+  std::string out;
+  out.reserve(s.size());
+  prom_append_name(out, s);
+  return out;
+}
+
+///\brief Render a metric name as a prometheus name, using underscores as separators.
+inline auto prom_name(const metric_name& name) -> std::string {
+  // The path separator is not allowed in a prometheus name, so it is replaced with an underscore.
+  static_assert(!prom_name_char('.', false));
+  return prom_name(name.path());
+}
+
+/**
+ * \brief Append a number.
+ * \details
+ * Floating point values are formatted as `%g`, with precision 6,
+ * which is what an ostream with default flags produces.
+ * The caller must handle NaN and infinity.
+ */
+template<typename T>
+inline void prom_append_number(std::string& out, T v) {
+  if constexpr(std::is_floating_point_v<T>)
+    append_general(out, v, 6);
+  else
+    append_integer(out, v);
+}
+
+///\brief Append a quoted and escaped string.
+inline void prom_append_quoted(std::string& out, std::string_view s) {
+  out.push_back('"');
+
+  std::size_t start = 0;
+  for (std::size_t i = 0; i < s.size(); ++i) {
+    std::string_view esc;
+    switch (s[i]) {
+    default:
+      continue;
+    case '\n':
+      esc = R"(\n)";
+      break;
+    case '\\':
+      esc = R"(\\)";
+      break;
+    case '"':
+      esc = R"(\")";
+      break;
+    }
+
+    out.append(s.substr(start, i - start)).append(esc);
+    start = i + 1u;
+  }
+
+  out.append(s.substr(start));
+  out.push_back('"');
+}
+
+///\brief Quote and escape a string.
+inline auto prom_quote(std::string_view s) -> std::string {
+  std::string out;
+  out.reserve(s.size() + 2u);
+  prom_append_quoted(out, s);
+  return out;
+}
+
+///\brief Append a floating point label value.
+inline void prom_append_label_value(std::string& out, double v) {
+  if (std::isnan(v)) {
+    out.append(R"("NaN")");
+  } else if (std::isinf(v)) {
+    out.append(v < 0 ? R"(-Inf)" : R"(+Inf)");
+  } else {
+    out.push_back('"');
+    prom_append_number(out, v);
+    out.push_back('"');
+  }
+}
+
+///\brief Append a label value.
+inline void prom_append_label_value(std::string& out, const tags::tag_value& tv) {
+  std::visit(
+      [&out](const auto& v) {
+        if constexpr(std::is_same_v<bool, std::decay_t<decltype(v)>>) {
+          out.append(v ? R"("true")" : R"("false")");
+        } else if constexpr(std::is_same_v<std::int64_t, std::decay_t<decltype(v)>>) {
+          out.push_back('"');
+          prom_append_number(out, v);
+          out.push_back('"');
+        } else if constexpr(std::is_same_v<double, std::decay_t<decltype(v)>>) {
+          prom_append_label_value(out, v);
+        } else {
+          prom_append_quoted(out, v);
+        }
+      },
+      tv);
+}
+
+///\brief Render a label value.
+inline auto prom_label_value(const tags::tag_value& tv) -> std::string {
+  std::string out;
+  prom_append_label_value(out, tv);
+  return out;
+}
+
+
+/**
+ * \brief Render the metrics of \p e using up to \p threads threads, and append the result to \p out.
+ * \details
+ * Each chunk of metric groups is rendered by its own Collector, into its own buffer.
+ * The Collector must be constructible from a `std::string&`, and have a `flush()` method.
+ */
+template<typename Collector>
+void prom_collect_parallel(std::string& out, const engine& e, unsigned int threads) {
+  // Use more chunks than threads, so threads that finish early can pick up more work.
+  const std::size_t chunks = 4u * std::max(threads, 1u);
+
+  std::vector<std::string> buffers(chunks);
+  std::vector<std::unique_ptr<Collector>> collectors;
+  std::vector<collector*> collector_ptrs;
+  collectors.reserve(chunks);
+  collector_ptrs.reserve(chunks);
+  for (std::string& buf : buffers) {
+    collectors.push_back(std::make_unique<Collector>(buf));
+    collector_ptrs.push_back(collectors.back().get());
+  }
+
+  e.collect_parallel(collector_ptrs, threads);
+
+  std::size_t total = out.size();
+  for (std::size_t i = 0; i < chunks; ++i) {
+    collectors[i]->flush();
+    total += buffers[i].size();
+  }
+  out.reserve(total);
+  for (const std::string& buf : buffers) out.append(buf);
+}
+
+/**
+ * \brief Collect \p e using Collector, appending the gzip compressed output to \p out.
+ * \details
+ * The collector hands its output to the compressor each time its buffer fills up,
+ * so only one buffer of uncompressed output exists at any time.
+ */
+template<typename Collector>
+void prom_collect_gzip(std::string& out, const engine& e) {
+  gzip_writer gz(out);
+  std::string buf;
+  buf.reserve(Collector::flush_threshold + Collector::flush_threshold / 4u);
+
+  Collector pc(
+      buf,
+      [&gz](std::string_view s) {
+        gz.write(s);
+      });
+  e.collect(pc);
+  pc.flush();
+  gz.finish();
+}
+
+///\brief Collect \p e using Collector, writing the gzip compressed output to \p out.
+template<typename Collector>
+void prom_collect_gzip(std::ostream& out, const engine& e) {
+  std::string compressed;
+  gzip_writer gz(compressed);
+  std::string buf;
+  buf.reserve(Collector::flush_threshold + Collector::flush_threshold / 4u);
+
+  Collector pc(
+      buf,
+      [&gz, &out, &compressed](std::string_view s) {
+        gz.write(s);
+        out.write(compressed.data(), compressed.size());
+        compressed.clear();
+      });
+  e.collect(pc);
+  pc.flush();
+  gz.finish();
+  out.write(compressed.data(), compressed.size());
+}
+
+
+} /* namespace instrumentation::detail */
+
+#endif /* INSTRUMENTATION_SRC_PROM_TEXT_H */
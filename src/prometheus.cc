@@ -1,315 +1,227 @@
 #include <instrumentation/prometheus.h>
 #include <instrumentation/collector.h>
 #include <instrumentation/counter.h>
+#include <instrumentation/counter_u64.h>
 #include <instrumentation/gauge.h>
+#include <instrumentation/gauge_i64.h>
 #include <instrumentation/string.h>
+#include <instrumentation/summary.h>
 #include <instrumentation/timing.h>
 #include <instrumentation/engine.h>
 #include <instrumentation/metric_name.h>
+#include <instrumentation/label_fragment.h>
 #include <instrumentation/tags.h>
+#include "prom_text.h"
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
-#include <ios>
-#include <iterator>
-#include <map>
+#include <functional>
+#include <limits>
 #include <optional>
 #include <ostream>
-#include <regex>
-#include <sstream>
 #include <string>
 #include <string_view>
 #include <type_traits>
-#include <variant>
 
 namespace instrumentation {
 namespace {
 
 
-class flag_manager {
-  public:
-  flag_manager() = default;
-
-  flag_manager(std::ios_base& out)
-  : stream_(&out),
-    saved_(stream_->flags())
-  {
-    stream_->setf(std::ios_base::fmtflags(0), std::ios_base::floatfield);
-  }
-
-  flag_manager(const flag_manager&) = delete;
-  flag_manager& operator=(const flag_manager&) = delete;
-
-  flag_manager(flag_manager&& y)
-      noexcept(std::is_nothrow_move_constructible_v<std::ios_base::fmtflags>)
-  : stream_(std::exchange(y.stream_, nullptr)),
-    saved_(std::move_if_noexcept(y.saved_))
-  {}
-
-  flag_manager& operator=(flag_manager&& y)
-      noexcept(std::is_nothrow_move_assignable_v<std::ios_base::fmtflags>) {
-    if (stream_ != nullptr) stream_->flags(saved_);
-
-    stream_ = std::exchange(y.stream_, nullptr);
-    saved_ = std::move(y.saved_);
-    return *this;
-  }
-
-  ~flag_manager() noexcept {
-    if (stream_ != nullptr) stream_->flags(saved_);
-  }
-
-  private:
-  std::ios_base* stream_ = nullptr;
-  std::ios_base::fmtflags saved_;
-};
-
-
-class locale_manager {
-  public:
-  locale_manager() = default;
-
-  locale_manager(std::ios_base& out)
-  : stream_(&out),
-    saved_(stream_->imbue(std::locale::classic()))
-  {}
-
-  locale_manager(const locale_manager&) = delete;
-  locale_manager& operator=(const locale_manager&) = delete;
-
-  locale_manager(locale_manager&& y) noexcept
-  : stream_(std::exchange(y.stream_, nullptr)),
-    saved_(y.saved_)
-  {}
-
-  locale_manager& operator=(locale_manager&& y) noexcept {
-    if (stream_ != nullptr) stream_->imbue(saved_);
-
-    stream_ = std::exchange(y.stream_, nullptr);
-    saved_ = y.saved_;
-    return *this;
-  }
-
-  ~locale_manager() noexcept {
-    if (stream_ != nullptr) stream_->imbue(saved_);
-  }
-
-  private:
-  std::ios_base* stream_ = nullptr;
-  std::locale saved_;
-};
-
-
-class stream_manager {
-  public:
-  stream_manager() = default;
-
-  stream_manager(std::ios_base& out)
-  : loc_(out),
-    fl_(out)
-  {}
-
-  private:
-  locale_manager loc_;
-  flag_manager fl_;
-};
-
-
+/*
+ * Renders the prometheus text format.
+ *
+ * Output is appended to a string.
+ * If a sink is present, the string is handed to the sink and cleared,
+ * whenever it grows past the flush threshold.
+ * Without a sink, the string accumulates all output.
+ */
 class prom_collector
 : public collector
 {
   public:
-  prom_collector(std::ostream& out)
-  : out(out)
+  using sink_type = std::function<void(std::string_view)>;
+  static constexpr std::size_t flush_threshold = 64u * 1024u;
+
+  explicit prom_collector(std::string& out, sink_type sink = nullptr)
+  : out(out),
+    sink(std::move(sink))
   {}
 
   void visit_description(const metric_name& name, std::string_view description) override {
-    pending_help.emplace(fix_prom_descr(description));
+    pending_help.emplace(description);
+
+    // Each metric group starts with its description, so render its name here.
+    cached_name = detail::prom_name(name);
+    cached_name_for = &name;
   }
 
   void visit(const metric_name& name, const tags& t, const counter& c) override {
     write_(name, t, *c, "counter");
   }
 
+  void visit(const metric_name& name, const tags& t, const counter_u64& c) override {
+    write_(name, t, *c, "counter");
+  }
+
   void visit(const metric_name& name, const tags& t, const gauge& g) override {
     write_(name, t, *g, "gauge");
   }
 
+  void visit(const metric_name& name, const tags& t, const gauge_i64& g) override {
+    write_(name, t, *g, "gauge");
+  }
+
   void visit(const metric_name& name, const tags& t, const string& s) override {
-    if (t.data().count("strval") == 0) {
-      tags tag_copy = t;
-      tag_copy.with("strval", *s);
-      write_(name, tag_copy, 1.0, "untyped");
+    if (t.count("strval") == 0) {
+      extra_value.clear();
+      detail::prom_append_quoted(extra_value, *s);
+      write_(name, t, 1.0, "untyped", "", "strval", extra_value);
     }
   }
 
   void visit(const metric_name& name, const tags& t, const timing& m) override {
     const auto h = *m;
 
-    tags tag_copy = t;
     std::uint64_t cumulative_count = 0;
     for (const timing::histogram_entry& he : std::get<0>(h)) {
       std::chrono::duration<double> d = he.le;
-      tag_copy.with("le", d.count());
-
       cumulative_count += he.bucket_count;
 
-      write_(name, tag_copy, cumulative_count, "histogram");
+      extra_value.clear();
+      detail::prom_append_label_value(extra_value, d.count());
+      write_(name, t, cumulative_count, "histogram", "", "le", extra_value);
     }
 
-    tag_copy.with("le", "+Inf");
-    write_(name, tag_copy, cumulative_count + std::get<1>(h), "histogram");
+    write_(name, t, cumulative_count + std::get<1>(h), "histogram", "", "le", R"("+Inf")");
+  }
+
+  void visit(const metric_name& name, const tags& t, const summary& m) override {
+    const auto [quantiles, count, sum] = *m;
+
+    for (const summary::quantile_entry& qe : quantiles) {
+      extra_value.clear();
+      detail::prom_append_label_value(extra_value, qe.quantile);
+
+      if (count == 0u)
+        write_(name, t, std::numeric_limits<double>::quiet_NaN(), "summary", "", "quantile", extra_value);
+      else
+        write_(name, t, std::chrono::duration<double>(qe.value).count(), "summary", "", "quantile", extra_value);
+    }
+
+    write_(name, t, std::chrono::duration<double>(sum).count(), "summary", "_sum");
+    write_(name, t, count, "summary", "_count");
+  }
+
+  ///\brief Hand any remaining output to the sink.
+  void flush() {
+    if (sink && !out.empty()) {
+      sink(out);
+      out.clear();
+    }
   }
 
   private:
   template<typename T>
-  void write_(const metric_name& name, const tags& t, const T& v, const char* metric_type = "untyped") {
-    const auto pm_name = prom_metric_name(name);
+  void write_(const metric_name& name, const tags& t, const T& v, std::string_view metric_type = "untyped", std::string_view suffix = "", std::string_view extra_name = "", std::string_view extra_value = "") {
+    const std::string_view pm_name = prom_metric_name_(name);
 
     if (pending_help) {
-      if (!pending_help->empty())
-        out << "# HELP " << pm_name << " " << *pending_help << "\n";
+      if (!pending_help->empty()) {
+        out.append("# HELP ").append(pm_name).append(1, ' ');
+        append_help_(*pending_help);
+        out.append(1, '\n');
+      }
       pending_help.reset();
-      out << "# TYPE " << pm_name << " " << metric_type << "\n";
+      out.append("# TYPE ").append(pm_name).append(1, ' ').append(metric_type).append(1, '\n');
     }
 
-    out << pm_name << "\t";
-    write_tags_(t);
+    out.append(pm_name).append(suffix).append(1, '\t');
+    write_tags_(t, extra_name, extra_value);
 
     if constexpr(std::is_floating_point_v<T>) {
       // For floating point, ensure we handle the edge cases correctly.
       if (std::isnan(v)) {
-        out << R"("NaN")";
+        out.append(R"("NaN")");
       } else if (std::isinf(v)) {
-        out << (v < 0 ? R"(-Inf)" : R"(+Inf)");
+        out.append(v < 0 ? R"(-Inf)" : R"(+Inf)");
       } else {
-        out << v;
+        detail::prom_append_number(out, v);
       }
     } else {
-      out << v;
+      detail::prom_append_number(out, v);
     }
 
-    out << "\n";
+    out.append(1, '\n');
+    if (sink && out.size() >= flush_threshold) flush();
   }
 
-  static auto prom_metric_name(const metric_name& name) -> std::string {
-    return fix_prom_name(name.with_separator("_"));
+  /*
+   * The sanitized name of the metric.
+   * A metric group hands the same metric_name to its description and to each of its samples,
+   * so the name rendered for the description is reused for the samples.
+   */
+  auto prom_metric_name_(const metric_name& name) -> std::string_view {
+    if (&name != cached_name_for) {
+      cached_name = detail::prom_name(name);
+      cached_name_for = &name;
+    }
+    return cached_name;
   }
 
-  void write_tags_(const tags& t) {
-    if (t.empty()) return;
-
-    std::map<std::string, std::string> tmp;
-    for (const auto& e : t.data()) {
-      std::string v_as_str = std::visit(
-          [](const auto& v) -> std::string {
-            if constexpr(std::is_same_v<bool, std::decay_t<decltype(v)>>) {
-              return v ? R"("true")" : R"("false")";
-            } else if constexpr(std::is_same_v<std::int64_t, std::decay_t<decltype(v)>>) {
-              std::ostringstream oss;
-              oss.setf(std::ios_base::dec, std::ios_base::basefield);
-              oss.imbue(std::locale::classic());
-              oss << v;
-              return quote_string(oss.str());
-            } else if constexpr(std::is_same_v<double, std::decay_t<decltype(v)>>) {
-              if (std::isnan(v)) {
-                return R"("NaN")";
-              } else if (std::isinf(v)) {
-                return v < 0 ? R"(-Inf)" : R"(+Inf)";
-              } else {
-                std::ostringstream oss;
-                oss.setf(std::ios_base::fmtflags(0), std::ios_base::floatfield);
-                oss.imbue(std::locale::classic());
-                oss << v;
-                return quote_string(oss.str());
-              }
-            } else {
-              return quote_string(v);
-            }
-          },
-          e.second);
-      tmp.emplace(
-          fix_prom_name(e.first),
-          v_as_str);
+  /*
+   * Write the label fragment of the tags.
+   * If extra_name is not empty, the extra label is merged into the fragment,
+   * replacing any tag with the same name.
+   */
+  void write_tags_(const tags& t, std::string_view extra_name, std::string_view extra_value) {
+    std::optional<label_fragment> tmp;
+    const label_fragment* f = t.fragment();
+    if (f == nullptr) f = &tmp.emplace(t);
+    const std::string_view text = f->text();
+
+    if (extra_name.empty()) {
+      if (text.empty()) return;
+      out.append(1, '{').append(text).append("}\t");
+    } else {
+      const auto [begin, end] = f->locate(extra_name);
+      out.append(1, '{')
+          .append(text.substr(0, begin))
+          .append(extra_name).append(1, '=').append(extra_value).append(1, ',')
+          .append(text.substr(end))
+          .append("}\t");
     }
-
-    out << "{";
-    for (const auto& e : tmp) out << e.first << "=" << e.second << ",";
-    out << "}\t";
   }
 
-  static auto fix_prom_descr(std::string_view s) -> std::string {
-    std::string out;
-    out.reserve(s.size());
-
-    for (const auto& c : s) {
-      switch (c) {
+  void append_help_(std::string_view s) {
+    std::size_t start = 0;
+    for (std::size_t i = 0; i < s.size(); ++i) {
+      std::string_view esc;
+      switch (s[i]) {
         default:
-          out.push_back(c);
-          break;
+          continue;
         case '\\':
-          out.append(R"(\\)");
+          esc = R"(\\)";
           break;
         case '\n':
-          out.append(R"(\n)");
+          esc = R"(\n)";
           break;
       }
-    }
-
-    return out;
-  }
 
-  static auto fix_prom_name(std::string_view s) -> std::string {
-    static const auto bad_start_characters = std::regex("[^a-zA-Z_:]");
-    static const auto bad_tail_characters = std::regex("[^a-zA-Z0-9_:]");
-
-    std::string out;
-    out.reserve(s.size());
-
-    if (!s.empty()) {
-      std::regex_replace(
-          std::back_inserter(out),
-          s.begin(), s.begin() + 1u,
-          bad_start_characters,
-          "_");
-      std::regex_replace(
-          std::back_inserter(out),
-          s.begin() + 1u, s.end(),
-          bad_tail_characters,
-          "_");
+      out.append(s.substr(start, i - start)).append(esc);
+      start = i + 1u;
     }
-
-    return out;
-  }
-
-  static auto quote_string(std::string_view s) -> std::string {
-    std::string out;
-    out.reserve(s.size() + 2u);
-
-    out.append(1, '"');
-
-    for (char c : s) {
-      switch (c) {
-      default:
-        out.push_back(c);
-        break;
-      case '\n':
-        out.append(R"(\n)");
-        break;
-      case '\\':
-        out.append(R"(\\)");
-        break;
-      case '"':
-        out.append(R"(\")");
-        break;
-      }
-    }
-
-    out.append(1, '"');
-    return out;
+    out.append(s.substr(start));
   }
 
-  std::ostream& out;
-  std::optional<std::string> pending_help;
+  std::string& out;
+  sink_type sink;
+  // Description of the current metric group, until its TYPE line is written.
+  std::optional<std::string_view> pending_help;
+  // Rendered value of the extra label, reused between samples.
+  std::string extra_value;
+  // Sanitized name, and the metric name it was rendered from.
+  std::string cached_name;
+  const metric_name* cached_name_for = nullptr;
 };
 
 
@@ -321,21 +233,75 @@ void collect_prometheus(std::ostream& out) {
 }
 
 void collect_prometheus(std::ostream& out, const engine& e) {
-  stream_manager sm{ out };
+  std::string buf;
+  buf.reserve(prom_collector::flush_threshold + prom_collector::flush_threshold / 4u);
+
+  prom_collector pc(
+      buf,
+      [&out](std::string_view s) {
+        out.write(s.data(), s.size());
+      });
+  e.collect(pc);
+  pc.flush();
+}
+
+void collect_prometheus(std::string& out) {
+  return collect_prometheus(out, engine::global());
+}
+
+void collect_prometheus(std::string& out, const engine& e) {
   prom_collector pc(out);
   e.collect(pc);
 }
 
 auto collect_prometheus() -> std::string {
-  std::ostringstream oss;
-  collect_prometheus(oss);
-  return std::move(oss).str();
+  return collect_prometheus(engine::global());
 }
 
 auto collect_prometheus(const engine& e) -> std::string {
-  std::ostringstream oss;
-  collect_prometheus(oss, e);
-  return std::move(oss).str();
+  std::string out;
+  collect_prometheus(out, e);
+  return out;
+}
+
+void collect_prometheus_parallel(std::string& out, const engine& e, unsigned int threads) {
+  detail::prom_collect_parallel<prom_collector>(out, e, threads);
+}
+
+auto collect_prometheus_parallel(const engine& e, unsigned int threads) -> std::string {
+  std::string out;
+  collect_prometheus_parallel(out, e, threads);
+  return out;
+}
+
+auto prometheus_gzip_supported() noexcept -> bool {
+  return detail::gzip_supported();
+}
+
+void collect_prometheus_gzip(std::ostream& out) {
+  return collect_prometheus_gzip(out, engine::global());
+}
+
+void collect_prometheus_gzip(std::ostream& out, const engine& e) {
+  detail::prom_collect_gzip<prom_collector>(out, e);
+}
+
+void collect_prometheus_gzip(std::string& out) {
+  return collect_prometheus_gzip(out, engine::global());
+}
+
+void collect_prometheus_gzip(std::string& out, const engine& e) {
+  detail::prom_collect_gzip<prom_collector>(out, e);
+}
+
+auto collect_prometheus_gzip() -> std::string {
+  return collect_prometheus_gzip(engine::global());
+}
+
+auto collect_prometheus_gzip(const engine& e) -> std::string {
+  std::string out;
+  collect_prometheus_gzip(out, e);
+  return out;
 }
 
 
@@ -0,0 +1,416 @@
+#include <instrumentation/prometheus.h>
+#include <instrumentation/collector.h>
+#include <instrumentation/counter.h>
+#include <instrumentation/counter_u64.h>
+#include <instrumentation/gauge.h>
+#include <instrumentation/gauge_i64.h>
+#include <instrumentation/string.h>
+#include <instrumentation/summary.h>
+#include <instrumentation/timing.h>
+#include <instrumentation/engine.h>
+#include <instrumentation/metric_name.h>
+#include <instrumentation/tags.h>
+#include "prom_text.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace instrumentation {
+namespace {
+
+
+/*
+ * Minimal protobuf encoder.
+ *
+ * Nested messages are written in place: a single length byte is reserved,
+ * and widened once the message is complete, if the message turned out
+ * to be 128 bytes or longer.
+ */
+class proto_writer {
+  public:
+  enum wire_type : std::uint32_t {
+    varint_type = 0,
+    fixed64_type = 1,
+    length_delimited_type = 2,
+  };
+
+  explicit proto_writer(std::string& out)
+  : out(out)
+  {}
+
+  void varint(std::uint64_t v) {
+    while (v >= 0x80u) {
+      out.push_back(static_cast<char>((v & 0x7fu) | 0x80u));
+      v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+  }
+
+  void tag(std::uint32_t field, wire_type wt) {
+    varint((std::uint64_t(field) << 3) | wt);
+  }
+
+  void field_varint(std::uint32_t field, std::uint64_t v) {
+    tag(field, varint_type);
+    varint(v);
+  }
+
+  void field_double(std::uint32_t field, double v) {
+    std::uint64_t bits;
+    static_assert(sizeof(bits) == sizeof(v));
+    std::memcpy(&bits, &v, sizeof(bits));
+
+    tag(field, fixed64_type);
+    for (int i = 0; i < 8; ++i, bits >>= 8) out.push_back(static_cast<char>(bits & 0xffu));
+  }
+
+  void field_string(std::uint32_t field, std::string_view s) {
+    tag(field, length_delimited_type);
+    varint(s.size());
+    out.append(s);
+  }
+
+  ///\brief Start a nested message in \p field.
+  auto begin_message(std::uint32_t field) -> std::size_t {
+    tag(field, length_delimited_type);
+    return begin_delimited();
+  }
+
+  ///\brief Start a length-prefixed message without field tag.
+  auto begin_delimited() -> std::size_t {
+    out.push_back('\0');
+    return out.size();
+  }
+
+  ///\brief Complete the message that started at \p start.
+  void end_message(std::size_t start) {
+    const std::size_t len = out.size() - start;
+
+    char buf[10];
+    std::size_t n = 0;
+    for (std::uint64_t v = len; ; v >>= 7) {
+      buf[n++] = static_cast<char>(v >= 0x80u ? ((v & 0x7fu) | 0x80u) : v);
+      if (v < 0x80u) break;
+    }
+
+    if (n > 1u) out.insert(start, n - 1u, '\0');
+    out.replace(start - 1u, n, buf, n);
+  }
+
+  private:
+  std::string& out;
+};
+
+
+/*
+ * Renders the prometheus protobuf format:
+ * a sequence of io.prometheus.client.MetricFamily messages, each prefixed with its length.
+ *
+ * Each metric group becomes one metric family.
+ * Families are only emitted if the group has at least one series.
+ */
+class prom_protobuf_collector
+: public collector
+{
+  public:
+  using sink_type = std::function<void(std::string_view)>;
+  static constexpr std::size_t flush_threshold = 64u * 1024u;
+
+  // io.prometheus.client.MetricType
+  enum metric_type : std::uint64_t {
+    counter_type = 0,
+    gauge_type = 1,
+    summary_type = 2,
+    untyped_type = 3,
+    histogram_type = 4,
+  };
+
+  explicit prom_protobuf_collector(std::string& out, sink_type sink = nullptr)
+  : out(out),
+    pw(out),
+    sink(std::move(sink))
+  {}
+
+  void visit_description(const metric_name& name, std::string_view description) override {
+    end_family_();
+
+    pending_name = detail::prom_name(name);
+    pending_help = description;
+  }
+
+  void visit(const metric_name& name [[maybe_unused]], const tags& t, const counter& c) override {
+    write_value_(t, counter_type, 3, *c);
+  }
+
+  void visit(const metric_name& name [[maybe_unused]], const tags& t, const counter_u64& c) override {
+    write_value_(t, counter_type, 3, static_cast<double>(*c));
+  }
+
+  void visit(const metric_name& name [[maybe_unused]], const tags& t, const gauge& g) override {
+    write_value_(t, gauge_type, 2, *g);
+  }
+
+  void visit(const metric_name& name [[maybe_unused]], const tags& t, const gauge_i64& g) override {
+    write_value_(t, gauge_type, 2, static_cast<double>(*g));
+  }
+
+  void visit(const metric_name& name [[maybe_unused]], const tags& t, const string& s) override {
+    if (t.count("strval") != 0) return;
+
+    const std::size_t metric = begin_metric_(untyped_type);
+    write_labels_(t, "strval", *s);
+    const std::size_t untyped = pw.begin_message(5);
+    pw.field_double(1, 1.0);
+    pw.end_message(untyped);
+    pw.end_message(metric);
+  }
+
+  void visit(const metric_name& name [[maybe_unused]], const tags& t, const timing& m) override {
+    const auto h = *m;
+
+    const std::size_t metric = begin_metric_(histogram_type);
+    write_labels_(t);
+    const std::size_t histogram = pw.begin_message(7);
+
+    std::uint64_t cumulative_count = 0;
+    for (const timing::histogram_entry& he : std::get<0>(h)) cumulative_count += he.bucket_count;
+    pw.field_varint(1, cumulative_count + std::get<1>(h)); // sample_count
+
+    // The +Inf bucket is implied by sample_count.
+    cumulative_count = 0;
+    for (const timing::histogram_entry& he : std::get<0>(h)) {
+      cumulative_count += he.bucket_count;
+
+      const std::size_t bucket = pw.begin_message(3);
+      pw.field_varint(1, cumulative_count);
+      pw.field_double(2, std::chrono::duration<double>(he.le).count());
+      pw.end_message(bucket);
+    }
+
+    pw.end_message(histogram);
+    pw.end_message(metric);
+  }
+
+  void visit(const metric_name& name [[maybe_unused]], const tags& t, const summary& m) override {
+    const auto [quantiles, count, sum] = *m;
+
+    const std::size_t metric = begin_metric_(summary_type);
+    write_labels_(t);
+    const std::size_t summary_msg = pw.begin_message(4);
+    pw.field_varint(1, count);
+    pw.field_double(2, std::chrono::duration<double>(sum).count());
+    for (const summary::quantile_entry& qe : quantiles) {
+      const std::size_t quantile = pw.begin_message(3);
+      pw.field_double(1, qe.quantile);
+      pw.field_double(2, count == 0u ? std::numeric_limits<double>::quiet_NaN() : std::chrono::duration<double>(qe.value).count());
+      pw.end_message(quantile);
+    }
+    pw.end_message(summary_msg);
+    pw.end_message(metric);
+  }
+
+  ///\brief Complete the last family, and hand any remaining output to the sink.
+  void flush() {
+    end_family_();
+    if (sink && !out.empty()) {
+      sink(out);
+      out.clear();
+    }
+  }
+
+  private:
+  // Write a metric holding a single value, in the Counter, Gauge or Untyped message at field.
+  void write_value_(const tags& t, metric_type type, std::uint32_t field, double v) {
+    const std::size_t metric = begin_metric_(type);
+    write_labels_(t);
+    const std::size_t value = pw.begin_message(field);
+    pw.field_double(1, v);
+    pw.end_message(value);
+    pw.end_message(metric);
+  }
+
+  // Start a Metric message, starting the family if this is the first metric in the group.
+  auto begin_metric_(metric_type type) -> std::size_t {
+    if (!family.has_value()) {
+      family = pw.begin_delimited();
+      pw.field_string(1, pending_name);
+      if (!pending_help.empty()) pw.field_string(2, pending_help);
+      pw.field_varint(3, type);
+    }
+
+    return pw.begin_message(4);
+  }
+
+  void end_family_() {
+    if (family.has_value()) {
+      pw.end_message(*family);
+      family.reset();
+      if (sink && out.size() >= flush_threshold) flush();
+    }
+  }
+
+  /*
+   * Write the label pairs, sorted by name.
+   * If extra_name is not empty, it is added to the labels, replacing any tag with the same name.
+   */
+  void write_labels_(const tags& t, std::string_view extra_name = "", std::string_view extra_value = "") {
+    std::size_t n = 0;
+    for (const auto& e : t) {
+      if (n == labels.size()) labels.emplace_back();
+      auto& [label_name, label_value] = labels[n];
+
+      label_name.clear();
+      detail::prom_append_name(label_name, e.first);
+      if (!extra_name.empty() && label_name == extra_name) continue;
+      label_value.clear();
+      append_label_value_(label_value, e.second);
+      ++n;
+    }
+
+    if (!extra_name.empty()) {
+      if (n == labels.size()) labels.emplace_back();
+      labels[n].first.assign(extra_name);
+      labels[n].second.assign(extra_value);
+      ++n;
+    }
+
+    // Tags are sorted by name, so this only sorts if the extra label or sanitizing the names changed the order.
+    // Sanitizing may also make names collide: as in label_fragment, the first tag in name order is kept.
+    const auto by_name =
+        [](const auto& x, const auto& y) {
+          return x.first < y.first;
+        };
+    if (!std::is_sorted(labels.begin(), labels.begin() + n, by_name)) std::stable_sort(labels.begin(), labels.begin() + n, by_name);
+    for (std::size_t i = 0; i < n; ++i) {
+      if (i > 0u && labels[i].first == labels[i - 1u].first) continue;
+
+      const std::size_t pair = pw.begin_message(1);
+      pw.field_string(1, labels[i].first);
+      pw.field_string(2, labels[i].second);
+      pw.end_message(pair);
+    }
+  }
+
+  static void append_label_value_(std::string& out, const tags::tag_value& tv) {
+    std::visit(
+        [&out](const auto& v) {
+          if constexpr(std::is_same_v<bool, std::decay_t<decltype(v)>>) {
+            out.append(v ? "true" : "false");
+          } else if constexpr(std::is_same_v<std::int64_t, std::decay_t<decltype(v)>>) {
+            detail::prom_append_number(out, v);
+          } else if constexpr(std::is_same_v<double, std::decay_t<decltype(v)>>) {
+            if (std::isnan(v))
+              out.append("NaN");
+            else if (std::isinf(v))
+              out.append(v < 0 ? "-Inf" : "+Inf");
+            else
+              detail::prom_append_number(out, v);
+          } else {
+            out.append(v);
+          }
+        },
+        tv);
+  }
+
+  std::string& out;
+  proto_writer pw;
+  sink_type sink;
+  // Name and description of the current metric group.
+  std::string pending_name;
+  std::string_view pending_help;
+  // Start of the current metric family, if it has been started.
+  std::optional<std::size_t> family;
+  // Label pairs, reused between series.
+  std::vector<std::pair<std::string, std::string>> labels;
+};
+
+
+} /* namespace instrumentation::<unnamed> */
+
+
+void collect_prometheus_protobuf(std::ostream& out) {
+  return collect_prometheus_protobuf(out, engine::global());
+}
+
+void collect_prometheus_protobuf(std::ostream& out, const engine& e) {
+  std::string buf;
+  buf.reserve(prom_protobuf_collector::flush_threshold + prom_protobuf_collector::flush_threshold / 4u);
+
+  prom_protobuf_collector pc(
+      buf,
+      [&out](std::string_view s) {
+        out.write(s.data(), s.size());
+      });
+  e.collect(pc);
+  pc.flush();
+}
+
+void collect_prometheus_protobuf(std::string& out) {
+  return collect_prometheus_protobuf(out, engine::global());
+}
+
+void collect_prometheus_protobuf(std::string& out, const engine& e) {
+  prom_protobuf_collector pc(out);
+  e.collect(pc);
+  pc.flush();
+}
+
+auto collect_prometheus_protobuf() -> std::string {
+  return collect_prometheus_protobuf(engine::global());
+}
+
+auto collect_prometheus_protobuf(const engine& e) -> std::string {
+  std::string out;
+  collect_prometheus_protobuf(out, e);
+  return out;
+}
+
+void collect_prometheus_protobuf_parallel(std::string& out, const engine& e, unsigned int threads) {
+  detail::prom_collect_parallel<prom_protobuf_collector>(out, e, threads);
+}
+
+auto collect_prometheus_protobuf_parallel(const engine& e, unsigned int threads) -> std::string {
+  std::string out;
+  collect_prometheus_protobuf_parallel(out, e, threads);
+  return out;
+}
+
+void collect_prometheus_protobuf_gzip(std::ostream& out) {
+  return collect_prometheus_protobuf_gzip(out, engine::global());
+}
+
+void collect_prometheus_protobuf_gzip(std::ostream& out, const engine& e) {
+  detail::prom_collect_gzip<prom_protobuf_collector>(out, e);
+}
+
+void collect_prometheus_protobuf_gzip(std::string& out) {
+  return collect_prometheus_protobuf_gzip(out, engine::global());
+}
+
+void collect_prometheus_protobuf_gzip(std::string& out, const engine& e) {
+  detail::prom_collect_gzip<prom_protobuf_collector>(out, e);
+}
+
+auto collect_prometheus_protobuf_gzip() -> std::string {
+  return collect_prometheus_protobuf_gzip(engine::global());
+}
+
+auto collect_prometheus_protobuf_gzip(const engine& e) -> std::string {
+  std::string out;
+  collect_prometheus_protobuf_gzip(out, e);
+  return out;
+}
+
+
+} /* namespace instrumentation */
@@ -0,0 +1,469 @@
+#include <instrumentation/statsd.h>
+#include <instrumentation/collector.h>
+#include <instrumentation/counter.h>
+#include <instrumentation/counter_u64.h>
+#include <instrumentation/engine.h>
+#include <instrumentation/gauge.h>
+#include <instrumentation/gauge_i64.h>
+#include <instrumentation/metric_name.h>
+#include <instrumentation/string.h>
+#include <instrumentation/summary.h>
+#include <instrumentation/tags.h>
+#include <instrumentation/timing.h>
+#include "number_format.h"
+#include "posix_socket.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+namespace instrumentation {
+namespace {
+
+
+using detail::fd_handle;
+using detail::throw_errno;
+
+
+// Append s, with the characters that have a meaning in the statsd protocol replaced by an underscore.
+void append_sanitized(std::string& out, std::string_view s) {
+  for (char c : s) {
+    switch (c) {
+      default:
+        out.push_back(c);
+        break;
+      case ':':
+      case '|':
+      case '@':
+      case '#':
+      case ',':
+      case '\n':
+        out.push_back('_');
+        break;
+    }
+  }
+}
+
+// Append the shortest representation of v that reads back to the same value.
+template<typename T>
+void append_number(std::string& out, T v) {
+  if constexpr(std::is_floating_point_v<T>)
+    detail::append_shortest(out, v);
+  else
+    detail::append_integer(out, v);
+}
+
+void append_tag_value(std::string& out, const tags::tag_value& v) {
+  std::visit(
+      [&out](const auto& x) {
+        using type = std::decay_t<decltype(x)>;
+        if constexpr(std::is_same_v<type, bool>)
+          out.append(x ? "true" : "false");
+        else if constexpr(std::is_same_v<type, std::string>)
+          append_sanitized(out, x);
+        else
+          append_number(out, x);
+      },
+      v);
+}
+
+auto seconds(std::chrono::duration<double> d) noexcept -> double {
+  return d.count();
+}
+
+// Create a datagram socket, that is closed on exec.
+// SOCK_CLOEXEC is not available everywhere, so the flag is set afterwards.
+auto datagram_socket(int domain) -> fd_handle {
+  fd_handle fd(::socket(domain, SOCK_DGRAM, 0));
+  if (fd.get() == -1) throw_errno("socket");
+  if (::fcntl(fd.get(), F_SETFD, FD_CLOEXEC) == -1) throw_errno("fcntl");
+  return fd;
+}
+
+
+} /* namespace instrumentation::<unnamed> */
+
+
+/*
+ * The exporter renders lines while collecting, so it is its own collector.
+ *
+ * All rendering state, including the datagram buffer and the previous totals of the counters,
+ * is kept between flushes and protected by flush_mtx_.
+ */
+class statsd_exporter::impl
+: private collector
+{
+  public:
+  impl(const engine& e, fd_handle fd, statsd_options opts);
+  ~impl() noexcept override;
+
+  void flush();
+  auto dropped() const noexcept -> std::uint64_t { return dropped_.load(std::memory_order_relaxed); }
+  auto counters() -> std::size_t;
+
+  private:
+  void run_() noexcept;
+
+  void visit(const metric_name& name, const tags& t, const counter& v) override;
+  void visit(const metric_name& name, const tags& t, const counter_u64& v) override;
+  void visit(const metric_name& name, const tags& t, const gauge& v) override;
+  void visit(const metric_name& name, const tags& t, const gauge_i64& v) override;
+  void visit(const metric_name& name, const tags& t, const string& v) override;
+  void visit(const metric_name& name, const tags& t, const timing& v) override;
+  void visit(const metric_name& name, const tags& t, const summary& v) override;
+
+  // Render the name, with the prefix and suffix, into name_.
+  void set_name_(const metric_name& name, std::string_view suffix = std::string_view());
+  // Render the tags into tags_. The extra tag, if not empty, replaces any tag with the same name.
+  void set_tags_(const tags& t, std::string_view extra_name = std::string_view(), std::string_view extra_value = std::string_view());
+  // Total of a counter at the previous flush, and the most recent full flush that visited it.
+  template<typename T>
+  struct last_total {
+    T total = T();
+    std::uint64_t full_flush = 0;
+  };
+  template<typename T>
+  using last_totals = std::unordered_map<std::string, last_total<T>>;
+
+  // Increment of the counter named by name_ and tags_, since the previous flush.
+  template<typename T>
+  auto delta_(last_totals<T>& last, T total) -> T;
+  // Forget the counters that were not visited by the current full flush.
+  template<typename T>
+  void prune_(last_totals<T>& last) const;
+  // Write a counter line for name_ and tags_.
+  template<typename T>
+  void write_counter_(T delta);
+  // Write a gauge line for name_ and tags_.
+  template<typename T>
+  void write_gauge_(T value);
+  // Append the line for name_ and tags_ to line_.
+  template<typename T>
+  void append_line_(T value, std::string_view type);
+  // Add line_ to the datagram, sending the datagram first if the line doesn't fit.
+  void emit_();
+  void send_();
+
+  const engine& e_;
+  const statsd_options opts_;
+  const fd_handle fd_;
+  std::atomic<std::uint64_t> dropped_{ 0 };
+
+  std::mutex flush_mtx_;
+  engine::cursor cursor_;
+  std::string datagram_;
+  std::string line_;
+  std::string name_;
+  std::string tags_;
+  std::string key_;
+  std::string extra_value_;
+  // Name with prefix, and the metric name it was rendered from.
+  std::string base_name_;
+  const metric_name* base_name_for_ = nullptr;
+  // Totals of the counters at the previous flush, keyed by name and tags.
+  last_totals<double> last_double_;
+  last_totals<std::uint64_t> last_u64_;
+  // Number of flushes, and number of full flushes.
+  std::uint64_t flushes_ = 0;
+  std::uint64_t full_flushes_ = 0;
+
+  std::mutex stop_mtx_;
+  std::condition_variable stop_cv_;
+  bool stop_ = false;
+  std::thread thread_;
+};
+
+
+statsd_exporter::impl::impl(const engine& e, fd_handle fd, statsd_options opts)
+: e_(e),
+  opts_(std::move(opts)),
+  fd_(std::move(fd))
+{
+  if (opts_.interval <= std::chrono::milliseconds::zero()) throw std::logic_error("statsd_exporter requires a positive interval");
+  if (opts_.max_datagram == 0u) throw std::logic_error("statsd_exporter requires a positive datagram size");
+  if (opts_.full_flush_interval == 0u) throw std::logic_error("statsd_exporter requires a positive full flush interval");
+
+  datagram_.reserve(opts_.max_datagram);
+  thread_ = std::thread(&impl::run_, this);
+}
+
+statsd_exporter::impl::~impl() noexcept {
+  {
+    const std::lock_guard<std::mutex> lck{ stop_mtx_ };
+    stop_ = true;
+  }
+  stop_cv_.notify_one();
+  thread_.join();
+}
+
+void statsd_exporter::impl::run_() noexcept {
+  std::unique_lock<std::mutex> lck{ stop_mtx_ };
+  while (!stop_cv_.wait_for(lck, opts_.interval, [this]() { return stop_; })) {
+    lck.unlock();
+    try {
+      flush();
+    } catch (...) {
+      // Try again at the next interval.
+    }
+    lck.lock();
+  }
+  lck.unlock();
+
+  // Short lived processes rely on the final flush, to send what changed since the last interval.
+  try {
+    flush();
+  } catch (...) {
+  }
+}
+
+void statsd_exporter::impl::flush() {
+  const std::lock_guard<std::mutex> lck{ flush_mtx_ };
+  // The metric name of the previous flush may have been destroyed, and its address reused.
+  base_name_for_ = nullptr;
+
+  // A full flush visits every series, so counters that are not visited no longer exist.
+  const bool full = (flushes_++ % opts_.full_flush_interval == 0u);
+  if (full) {
+    ++full_flushes_;
+    cursor_ = engine::cursor();
+  }
+
+  e_.collect_changed(*this, cursor_);
+  send_();
+
+  if (full) {
+    prune_(last_double_);
+    prune_(last_u64_);
+  }
+}
+
+auto statsd_exporter::impl::counters() -> std::size_t {
+  const std::lock_guard<std::mutex> lck{ flush_mtx_ };
+  return last_double_.size() + last_u64_.size();
+}
+
+void statsd_exporter::impl::visit(const metric_name& name, const tags& t, const counter& v) {
+  set_name_(name);
+  set_tags_(t);
+  write_counter_(delta_(last_double_, *v));
+}
+
+void statsd_exporter::impl::visit(const metric_name& name, const tags& t, const counter_u64& v) {
+  set_name_(name);
+  set_tags_(t);
+  write_counter_(delta_(last_u64_, *v));
+}
+
+void statsd_exporter::impl::visit(const metric_name& name, const tags& t, const gauge& v) {
+  set_name_(name);
+  set_tags_(t);
+  write_gauge_(*v);
+}
+
+void statsd_exporter::impl::visit(const metric_name& name, const tags& t, const gauge_i64& v) {
+  set_name_(name);
+  set_tags_(t);
+  write_gauge_(*v);
+}
+
+void statsd_exporter::impl::visit([[maybe_unused]] const metric_name& name, [[maybe_unused]] const tags& t, [[maybe_unused]] const string& v) {
+  // StatsD has no string values.
+}
+
+void statsd_exporter::impl::visit(const metric_name& name, const tags& t, const timing& v) {
+  const auto [histogram, overflow] = *v;
+
+  set_name_(name, ".bucket");
+  std::uint64_t count = overflow;
+  for (const timing::histogram_entry& he : histogram) {
+    extra_value_.clear();
+    append_number(extra_value_, seconds(he.le));
+    set_tags_(t, "le", extra_value_);
+    write_counter_(delta_(last_u64_, he.bucket_count));
+    count += he.bucket_count;
+  }
+  set_tags_(t, "le", "+Inf");
+  write_counter_(delta_(last_u64_, overflow));
+
+  set_name_(name, ".count");
+  set_tags_(t);
+  write_counter_(delta_(last_u64_, count));
+}
+
+void statsd_exporter::impl::visit(const metric_name& name, const tags& t, const summary& v) {
+  const auto [quantiles, count, sum] = *v;
+
+  if (count != 0u) {
+    set_name_(name);
+    for (const summary::quantile_entry& qe : quantiles) {
+      extra_value_.clear();
+      append_number(extra_value_, qe.quantile);
+      set_tags_(t, "quantile", extra_value_);
+      write_gauge_(seconds(qe.value));
+    }
+  }
+
+  set_tags_(t);
+  set_name_(name, ".count");
+  write_counter_(delta_(last_u64_, count));
+  set_name_(name, ".sum");
+  write_counter_(delta_(last_double_, seconds(sum)));
+}
+
+void statsd_exporter::impl::set_name_(const metric_name& name, std::string_view suffix) {
+  if (&name != base_name_for_) {
+    base_name_ = opts_.prefix;
+    append_sanitized(base_name_, name.path());
+    base_name_for_ = &name;
+  }
+  name_.assign(base_name_).append(suffix);
+}
+
+void statsd_exporter::impl::set_tags_(const tags& t, std::string_view extra_name, std::string_view extra_value) {
+  tags_.clear();
+  for (const auto& [tag_name, tag_value] : t) {
+    if (!extra_name.empty() && tag_name == extra_name) continue;
+    if (!tags_.empty()) tags_.push_back(',');
+    append_sanitized(tags_, tag_name);
+    tags_.push_back(':');
+    append_tag_value(tags_, tag_value);
+  }
+
+  if (!extra_name.empty()) {
+    if (!tags_.empty()) tags_.push_back(',');
+    tags_.append(extra_name).append(1, ':').append(extra_value);
+  }
+}
+
+template<typename T>
+auto statsd_exporter::impl::delta_(last_totals<T>& last, T total) -> T {
+  key_.assign(name_).append(1, '|').append(tags_);
+  // The key is only copied when the counter is first seen.
+  last_total<T>& prev = last.try_emplace(key_).first->second;
+  // A total below the previous one means the series was removed and recreated.
+  const T delta = (total < prev.total ? total : total - prev.total);
+  prev.total = total;
+  prev.full_flush = full_flushes_;
+  return delta;
+}
+
+template<typename T>
+void statsd_exporter::impl::prune_(last_totals<T>& last) const {
+  for (auto iter = last.begin(); iter != last.end(); ) {
+    if (iter->second.full_flush != full_flushes_)
+      iter = last.erase(iter);
+    else
+      ++iter;
+  }
+}
+
+template<typename T>
+void statsd_exporter::impl::write_counter_(T delta) {
+  if constexpr(std::is_floating_point_v<T>) {
+    if (!std::isfinite(delta)) return;
+  }
+  if (delta == T()) return;
+
+  line_.clear();
+  append_line_(delta, "c");
+  emit_();
+}
+
+template<typename T>
+void statsd_exporter::impl::write_gauge_(T value) {
+  if constexpr(std::is_floating_point_v<T>) {
+    if (!std::isfinite(value)) return;
+  }
+
+  line_.clear();
+  // A gauge value with a sign is an adjustment, so a negative value is sent as a reset to zero followed by the adjustment.
+  // Both lines go into the same datagram, so they can't be reordered.
+  if (value < T()) {
+    append_line_(T(), "g");
+    line_.push_back('\n');
+  }
+  append_line_(value, "g");
+  emit_();
+}
+
+template<typename T>
+void statsd_exporter::impl::append_line_(T value, std::string_view type) {
+  line_.append(name_).append(1, ':');
+  append_number(line_, value);
+  line_.append(1, '|').append(type);
+  if (!tags_.empty()) line_.append("|#").append(tags_);
+}
+
+void statsd_exporter::impl::emit_() {
+  if (!datagram_.empty() && datagram_.size() + 1u + line_.size() > opts_.max_datagram) send_();
+
+  if (!datagram_.empty()) datagram_.push_back('\n');
+  datagram_.append(line_);
+  if (datagram_.size() >= opts_.max_datagram) send_();
+}
+
+void statsd_exporter::impl::send_() {
+  if (datagram_.empty()) return;
+
+  const auto wlen = ::send(fd_.get(), datagram_.data(), datagram_.size(), MSG_DONTWAIT);
+  if (wlen < 0 || std::size_t(wlen) != datagram_.size()) dropped_.fetch_add(1u, std::memory_order_relaxed);
+  datagram_.clear();
+}
+
+
+auto statsd_exporter::udp(const engine& e, const std::string& host, std::uint16_t port, statsd_options opts) -> statsd_exporter {
+  const detail::inet_address addr = detail::make_inet_address(host, port);
+
+  fd_handle fd = datagram_socket(addr.addr.ss_family);
+  if (::connect(fd.get(), addr.get(), addr.len) == -1) throw_errno("connect");
+
+  return statsd_exporter(std::make_unique<impl>(e, std::move(fd), std::move(opts)));
+}
+
+auto statsd_exporter::unix_socket(const engine& e, const std::string& path, statsd_options opts) -> statsd_exporter {
+  sockaddr_un addr{};
+  if (path.empty() || path.size() >= sizeof(addr.sun_path))
+    throw std::invalid_argument("statsd_exporter: invalid unix socket path");
+  addr.sun_family = AF_UNIX;
+  std::memcpy(addr.sun_path, path.data(), path.size());
+
+  fd_handle fd = datagram_socket(AF_UNIX);
+  if (::connect(fd.get(), reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == -1) throw_errno("connect");
+
+  return statsd_exporter(std::make_unique<impl>(e, std::move(fd), std::move(opts)));
+}
+
+statsd_exporter::statsd_exporter(std::unique_ptr<impl> impl) noexcept
+: impl_(std::move(impl))
+{}
+
+statsd_exporter::statsd_exporter(statsd_exporter&&) noexcept = default;
+auto statsd_exporter::operator=(statsd_exporter&&) noexcept -> statsd_exporter& = default;
+statsd_exporter::~statsd_exporter() noexcept = default;
+
+void statsd_exporter::flush() {
+  impl_->flush();
+}
+
+auto statsd_exporter::dropped() const noexcept -> std::uint64_t {
+  return impl_->dropped();
+}
+
+auto statsd_exporter::counters() const -> std::size_t {
+  return impl_->counters();
+}
+
+
+} /* namespace instrumentation */
@@ -0,0 +1,147 @@
+#include <instrumentation/summary.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <new>
+#include <stdexcept>
+
+namespace instrumentation::detail {
+namespace {
+
+
+auto validate_quantiles(std::vector<double> quantiles) -> std::vector<double> {
+  for (const double q : quantiles) {
+    if (!(q >= 0.0 && q <= 1.0))
+      throw std::logic_error("summary quantiles must be in the range [0, 1]");
+  }
+  return quantiles;
+}
+
+auto gamma_for(double relative_accuracy) -> double {
+  if (!(relative_accuracy > 0.0 && relative_accuracy < 1.0))
+    throw std::logic_error("summary relative accuracy must be in the range (0, 1)");
+  return (1.0 + relative_accuracy) / (1.0 - relative_accuracy);
+}
+
+
+} /* namespace instrumentation::detail::<unnamed> */
+
+
+summary_impl::summary_impl(std::vector<double> quantiles, double relative_accuracy)
+: quantiles_(validate_quantiles(std::move(quantiles))),
+  gamma_(gamma_for(relative_accuracy)),
+  inv_log_gamma_(1.0 / std::log(gamma_)),
+  nchunks_(key_(std::numeric_limits<duration::rep>::max()) / chunk_size + 1u),
+  chunks_(std::make_unique<std::atomic<chunk*>[]>(nchunks_))
+{}
+
+summary_impl::~summary_impl() noexcept {
+  for (std::size_t i = 0; i < nchunks_; ++i)
+    delete chunks_[i].load(std::memory_order_relaxed);
+}
+
+void summary_impl::inc(duration d, std::uint64_t v) noexcept {
+  generation_.touch();
+
+  const auto x = d.count();
+  sum_.fetch_add(x * static_cast<duration::rep>(v), std::memory_order_relaxed);
+
+  if (x <= 0) {
+    zero_.fetch_add(v, std::memory_order_relaxed);
+    return;
+  }
+
+  const std::size_t key = std::min(key_(x), nchunks_ * chunk_size - 1u);
+  std::atomic<chunk*>& slot = chunks_[key / chunk_size];
+  chunk* c = slot.load(std::memory_order_acquire);
+  if (c == nullptr) {
+    // Allocate the chunk on first use.
+    // If another thread beats us to it, we use theirs instead.
+    chunk* fresh = new (std::nothrow) chunk();
+    if (fresh == nullptr) return; // Drop the sample rather than throw.
+    if (slot.compare_exchange_strong(c, fresh, std::memory_order_acq_rel, std::memory_order_acquire))
+      c = fresh;
+    else
+      delete fresh;
+  }
+
+  c->v[key % chunk_size].fetch_add(v, std::memory_order_relaxed);
+}
+
+auto summary_impl::quantile(double q) const -> duration {
+  if (!(q >= 0.0 && q <= 1.0))
+    throw std::logic_error("summary quantile must be in the range [0, 1]");
+
+  const auto [bins, zero, count] = bins_();
+  return quantile_(q, bins, zero, count);
+}
+
+auto summary_impl::get_quantiles() const -> std::tuple<std::vector<quantile_entry>, std::uint64_t, duration> {
+  const auto [bins, zero, count] = bins_();
+
+  std::vector<quantile_entry> result;
+  result.reserve(quantiles_.size());
+  for (const double q : quantiles_)
+    result.push_back(quantile_entry{ q, quantile_(q, bins, zero, count) });
+
+  return std::make_tuple(std::move(result), count, duration(sum_.load(std::memory_order_relaxed)));
+}
+
+auto summary_impl::default_quantiles() -> std::vector<double> {
+  return std::vector<double>({ 0.5, 0.9, 0.99, 0.999 });
+}
+
+/*
+ * Bin k holds the durations in (gamma^(k-1), gamma^k] clock ticks.
+ */
+auto summary_impl::key_(duration::rep x) const noexcept -> std::size_t {
+  return static_cast<std::size_t>(std::ceil(std::log(static_cast<double>(x)) * inv_log_gamma_));
+}
+
+/*
+ * The estimate 2 gamma^k / (gamma + 1) is within the relative accuracy
+ * of every value in bin k.
+ */
+auto summary_impl::value_(std::size_t key) const noexcept -> duration {
+  const double v = 2.0 * std::pow(gamma_, static_cast<double>(key)) / (gamma_ + 1.0);
+  if (v >= static_cast<double>(std::numeric_limits<duration::rep>::max()))
+    return duration::max();
+  return duration(static_cast<duration::rep>(std::llround(v)));
+}
+
+auto summary_impl::quantile_(double q, const std::vector<std::uint64_t>& bins, std::uint64_t zero, std::uint64_t count) const -> duration {
+  if (count == 0u) return duration(0);
+
+  const double rank = q * static_cast<double>(count - 1u);
+  std::uint64_t n = zero;
+  if (static_cast<double>(n) > rank) return duration(0);
+
+  for (std::size_t key = 0; key < bins.size(); ++key) {
+    n += bins[key];
+    if (static_cast<double>(n) > rank) return value_(key);
+  }
+  return value_(bins.empty() ? 0u : bins.size() - 1u);
+}
+
+auto summary_impl::bins_() const -> std::tuple<std::vector<std::uint64_t>, std::uint64_t, std::uint64_t> {
+  std::vector<std::uint64_t> bins;
+  const std::uint64_t zero = zero_.load(std::memory_order_relaxed);
+  std::uint64_t count = zero;
+
+  for (std::size_t i = 0; i < nchunks_; ++i) {
+    const chunk* c = chunks_[i].load(std::memory_order_acquire);
+    if (c == nullptr) continue;
+
+    bins.resize(i * chunk_size + chunk_size);
+    for (std::size_t j = 0; j < chunk_size; ++j) {
+      const std::uint64_t v = c->v[j].load(std::memory_order_relaxed);
+      bins[i * chunk_size + j] = v;
+      count += v;
+    }
+  }
+
+  return std::make_tuple(std::move(bins), zero, count);
+}
+
+
+} /* namespace instrumentation::detail */
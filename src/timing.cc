@@ -1,67 +1,157 @@
 #include <instrumentation/timing.h>
+#include <instrumentation/striped.h>
 #include <algorithm>
-#include <iterator>
+#include <cstdint>
+#include <limits>
+#include <memory>
 #include <stdexcept>
 
 namespace instrumentation::detail {
+namespace {
 
-struct timing_impl::search_comparison {
-  template<typename X, typename Y>
-  auto operator()(const X& x, const Y& y) const noexcept -> bool {
-    return rep_(x) < rep_(y);
-  }
 
-  private:
-  static auto rep_(const timing_impl::duration& d) noexcept -> duration::rep {
-    return d.count();
-  }
+///\brief Number of bits required to represent \p v.
+inline auto bit_width(std::uint64_t v) noexcept -> unsigned int {
+#if defined(__GNUC__) || defined(__clang__)
+  return (v == 0u ? 0u : 64u - static_cast<unsigned int>(__builtin_clzll(v)));
+#else
+  unsigned int w = 0;
+  for (; v != 0u; v >>= 1) ++w;
+  return w;
+#endif
+}
+
+///\brief Largest supported precision for log-linear buckets.
+constexpr unsigned int max_log_linear_precision = 10;
 
-  static auto rep_(const timing_impl::bucket& b) noexcept -> duration::rep {
-    return b.le;
-  }
-};
 
+} /* namespace instrumentation::detail::<unnamed> */
 
-timing_impl::timing_impl(const std::vector<duration>& thresholds)
-: v_(thresholds.size())
+
+timing_impl::timing_impl(const std::vector<duration>& thresholds, timing_layout layout)
 {
-  auto v_iter = v_.begin();
+  le_.reserve(thresholds.size());
   for (const auto& threshold : thresholds) {
-    if (v_iter != v_.begin()) {
-      if (threshold.count() < std::prev(v_iter)->le)
+    if (!le_.empty()) {
+      if (threshold.count() < le_.back())
         throw std::logic_error("unsorted thresholds for timing metric");
-      if (threshold.count() == std::prev(v_iter)->le)
+      if (threshold.count() == le_.back())
         throw std::logic_error("duplicate thresholds for timing metric");
     }
 
-    v_iter++->le = threshold.count();
+    le_.push_back(threshold.count());
   }
+
+  init_counters_(layout);
+}
+
+timing_impl::timing_impl(const log_linear_buckets& buckets, timing_layout layout)
+: log_linear_(true),
+  ll_precision_(buckets.precision)
+{
+  if (buckets.resolution.count() <= 0)
+    throw std::logic_error("log-linear timing metric requires a positive resolution");
+  if (buckets.max < buckets.resolution)
+    throw std::logic_error("log-linear timing metric max is below its resolution");
+  if (buckets.max.count() > std::numeric_limits<duration::rep>::max() / 2)
+    throw std::logic_error("log-linear timing metric max is too large");
+  if (buckets.precision > max_log_linear_precision)
+    throw std::logic_error("log-linear timing metric precision is too large");
+
+  // Round the resolution down to a power of two.
+  ll_unit_shift_ = bit_width(static_cast<std::uint64_t>(buckets.resolution.count())) - 1u;
+
+  // The last bucket is the one holding max.
+  const std::size_t n = log_linear_index_(buckets.max) + 1u;
+  const std::size_t sub_buckets = std::size_t(1) << ll_precision_;
+
+  le_.reserve(n);
+  for (std::size_t idx = 0; idx < n; ++idx) {
+    // Bucket idx holds the values with mantissa m, shifted left by shift.
+    const std::size_t shift = (idx < sub_buckets ? 0u : (idx >> ll_precision_) - 1u);
+    const std::size_t m = idx - (shift << ll_precision_);
+    le_.push_back(static_cast<duration::rep>((m + 1u) << (shift + ll_unit_shift_)));
+  }
+
+  init_counters_(layout);
 }
 
 void timing_impl::inc(duration d, std::uint64_t v) noexcept {
-  const auto iter = std::lower_bound(
-      v_.begin(), v_.end(),
-      d,
-      search_comparison());
-  if (iter == v_.end())
-    large_v_.fetch_add(v, std::memory_order_relaxed);
-  else
-    iter->v.fetch_add(v, std::memory_order_relaxed);
+  inc_bucket(bucket_index(d), v);
+}
+
+auto timing_impl::bucket_count() const noexcept -> std::size_t {
+  return le_.size() + 1u;
+}
+
+auto timing_impl::bucket_index(duration d) const noexcept -> std::size_t {
+  if (log_linear_) return std::min(log_linear_index_(d), le_.size());
+  return std::lower_bound(le_.begin(), le_.end(), d.count()) - le_.begin();
+}
+
+void timing_impl::inc_bucket(std::size_t idx, std::uint64_t v) noexcept {
+  const std::size_t shard = (shard_mask_ == 0u ? 0u : stripe_index() & shard_mask_);
+  counter_(shard, idx).fetch_add(v, std::memory_order_relaxed);
+  generation_.touch();
 }
 
 auto timing_impl::get_histogram() const -> std::tuple<std::vector<histogram_entry>, std::uint64_t> {
   std::vector<histogram_entry> h;
-  if (!v_.empty()) {
-    h.reserve(v_.size());
-    for (const auto& bucket : v_) {
-      h.push_back(histogram_entry{
-          duration(bucket.le),
-          bucket.v.load(std::memory_order_relaxed)
-      });
-    }
+  h.reserve(le_.size());
+  for (std::size_t idx = 0; idx < le_.size(); ++idx) {
+    h.push_back(histogram_entry{
+        duration(le_[idx]),
+        sum_(idx)
+    });
   }
 
-  return std::make_tuple(std::move(h), large_v_.load(std::memory_order_relaxed));
+  return std::make_tuple(std::move(h), sum_(le_.size()));
+}
+
+void timing_impl::init_counters_(timing_layout layout) {
+  const std::size_t shards = (layout == timing_layout::sharded ? striped().size() : 1u);
+  stride_ = (layout == timing_layout::padded ? counters_per_line : 1u);
+  // Each shard starts on its own cache line.
+  shard_stride_ = (bucket_count() * stride_ + counters_per_line - 1u) / counters_per_line * counters_per_line;
+  shard_mask_ = shards - 1u;
+
+  counters_ = std::make_unique<counter_line[]>(shards * shard_stride_ / counters_per_line);
+}
+
+/*
+ * Buckets have an inclusive upper bound, so we index on d - 1,
+ * which maps each bucket onto a half-open range [lo, hi).
+ *
+ * Values below 2^(precision+1) units get a bucket each.
+ * Above that, the leading bit selects a power-of-two range,
+ * and the precision bits after it select the bucket in that range.
+ * Shifting the value right until only those bits remain
+ * yields the bucket within the range, offset by the index of the range.
+ */
+auto timing_impl::log_linear_index_(duration d) const noexcept -> std::size_t {
+  const auto x = d.count();
+  const std::uint64_t v = (x > 0 ? static_cast<std::uint64_t>(x - 1) : 0u) >> ll_unit_shift_;
+
+  const unsigned int w = bit_width(v | 1u);
+  const unsigned int shift = (w > ll_precision_ + 1u ? w - ll_precision_ - 1u : 0u);
+  return (std::size_t(shift) << ll_precision_) + static_cast<std::size_t>(v >> shift);
+}
+
+auto timing_impl::counter_(std::size_t shard, std::size_t idx) noexcept -> counter_type& {
+  const std::size_t pos = shard * shard_stride_ + idx * stride_;
+  return counters_[pos / counters_per_line].v[pos % counters_per_line];
+}
+
+auto timing_impl::counter_(std::size_t shard, std::size_t idx) const noexcept -> const counter_type& {
+  const std::size_t pos = shard * shard_stride_ + idx * stride_;
+  return counters_[pos / counters_per_line].v[pos % counters_per_line];
+}
+
+auto timing_impl::sum_(std::size_t idx) const noexcept -> std::uint64_t {
+  std::uint64_t sum = 0;
+  for (std::size_t shard = 0; shard <= shard_mask_; ++shard)
+    sum += counter_(shard, idx).load(std::memory_order_relaxed);
+  return sum;
 }
 
 auto timing_impl::default_buckets() -> std::vector<duration> {
@@ -0,0 +1,147 @@
+#include <instrumentation/batch.h>
+#include <instrumentation/engine.h>
+#include <instrumentation/time_track.h>
+#include <UnitTest++/UnitTest++.h>
+#include "print.h"
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace instrumentation;
+using namespace std::chrono_literals;
+
+TEST(counter_batch_publishes_on_destruction) {
+  engine e;
+  counter c = counter_vector<>(e, "test.metric", {}).labels();
+
+  {
+    counter_batch b(c);
+    ++b;
+    b++;
+    b += 17;
+    CHECK_EQUAL(0.0, *c);
+  }
+  CHECK_EQUAL(19.0, *c);
+}
+
+TEST(counter_batch_flush) {
+  engine e;
+  counter_u64 c = counter_u64_vector<>(e, "test.metric", {}).labels();
+
+  counter_u64_batch b(c);
+  b += 5;
+  CHECK_EQUAL(0u, *c);
+  b.flush();
+  CHECK_EQUAL(5u, *c);
+  b.flush();
+  CHECK_EQUAL(5u, *c);
+}
+
+TEST(no_metric_counter_batch_has_no_effect) {
+  counter_batch b{ counter() };
+  CHECK_EQUAL(true, !b);
+  ++b;
+  b.flush();
+}
+
+TEST(counter_batch_move_flushes_once) {
+  engine e;
+  counter c = counter_vector<>(e, "test.metric", {}).labels();
+
+  {
+    std::optional<counter_batch> stored;
+    {
+      counter_batch b(c);
+      b += 3;
+      stored.emplace(std::move(b));
+    }
+    // The moved-from batch published nothing.
+    CHECK_EQUAL(0.0, *c);
+
+    counter_batch assigned;
+    assigned = std::move(*stored);
+    stored.reset();
+    CHECK_EQUAL(0.0, *c);
+    assigned += 2;
+  }
+  CHECK_EQUAL(5.0, *c);
+}
+
+TEST(timing_batch_publishes_on_destruction) {
+  engine e;
+  timing t = timing_vector<>(e, "test.metric", {}, {3s, 5s}, "").labels();
+
+  {
+    timing_batch b(t);
+    b << 1s << 2s << 3s << 4s << 5s << 6s;
+    CHECK_EQUAL(0u, std::get<0>(*t)[0].bucket_count);
+  }
+
+  CHECK_EQUAL(
+      std::vector<timing::histogram_entry>({
+            { 3s, 3 }, // 1s, 2s, 3s
+            { 5s, 2 }, // 4s, 5s
+          }),
+      std::get<0>(*t));
+  CHECK_EQUAL(1u, std::get<1>(*t)); // 6s
+}
+
+TEST(timing_batch_flush) {
+  engine e;
+  timing t = timing_vector<>(e, "test.metric", {}, {3s, 5s}, "").labels();
+
+  timing_batch b(t);
+  b << 1s << 7s;
+  b.flush();
+  CHECK_EQUAL(1u, std::get<0>(*t)[0].bucket_count);
+  CHECK_EQUAL(1u, std::get<1>(*t));
+
+  b << 1s;
+  b.flush();
+  CHECK_EQUAL(2u, std::get<0>(*t)[0].bucket_count);
+  CHECK_EQUAL(1u, std::get<1>(*t));
+}
+
+TEST(timing_batch_move_flushes_once) {
+  engine e;
+  timing t = timing_vector<>(e, "test.metric", {}, {3s, 5s}, "").labels();
+
+  {
+    std::vector<timing_batch> batches;
+    {
+      timing_batch b(t);
+      b << 1s << 4s;
+      batches.push_back(std::move(b));
+      b << 1s; // The moved-from batch has no timing.
+    }
+    CHECK_EQUAL(0u, std::get<0>(*t)[0].bucket_count);
+  }
+
+  CHECK_EQUAL(
+      std::vector<timing::histogram_entry>({
+            { 3s, 1 },
+            { 5s, 1 },
+          }),
+      std::get<0>(*t));
+  CHECK_EQUAL(0u, std::get<1>(*t));
+}
+
+TEST(timing_batch_works_with_time_track) {
+  engine e;
+  timing t = timing_vector<>(e, "test.metric", {}, {}, "").labels();
+
+  {
+    timing_batch b(t);
+    {
+      time_track<timing_batch> tt(b);
+    }
+    CHECK_EQUAL(0u, std::get<1>(*t));
+  }
+
+  CHECK_EQUAL(1u, std::get<1>(*t));
+}
+
+int main() {
+  return UnitTest::RunAllTests();
+}
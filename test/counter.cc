@@ -2,7 +2,13 @@
 #include <instrumentation/engine.h>
 #include <UnitTest++/UnitTest++.h>
 #include "test_collector.h"
+#include <chrono>
+#include <map>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 using namespace instrumentation;
 
@@ -56,6 +62,245 @@ TEST(counter_vector) {
       test_collector(e));
 }
 
+TEST(striped_counter_ops) {
+  engine e;
+  counter c = counter_vector<>(e, "test.metric", {}, striped(4)).labels();
+
+  REQUIRE CHECK_EQUAL(0.0, *c);
+  ++c;
+  CHECK_EQUAL(1.0, *c);
+  c++;
+  CHECK_EQUAL(2.0, *c);
+  c += 17;
+  CHECK_EQUAL(19.0, *c);
+}
+
+TEST(striped_counter_sums_all_threads) {
+  engine e;
+  counter c = counter_vector<>(e, "test.metric", {}, striped(4)).labels();
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back(
+        [c]() {
+          for (int j = 0; j < 1000; ++j) ++c;
+        });
+  }
+  for (auto& t : threads) t.join();
+
+  CHECK_EQUAL(8000.0, *c);
+}
+
+TEST(striped_counter_vector) {
+  engine e;
+  counter_vector<std::string> cv(e, "test.metric", {"label_name"}, striped(), "this is a test");
+
+  cv.labels("foo") += 11;
+  cv.labels("bar") += 17;
+
+  CHECK_EQUAL(
+      test_collector(
+          { {"test.metric", "this is a test"} },
+          { {"test.metric{label_name=\"foo\"}", std::to_string(11.0)},
+            {"test.metric{label_name=\"bar\"}", std::to_string(17.0)}
+          }),
+      test_collector(e));
+}
+
+TEST(counter_vector_string_view_labels) {
+  engine e;
+  counter_vector<std::string, int> cv(e, "test.metric", {"label_name", "id"});
+
+  const std::string foo = "foo";
+  cv.labels(foo, 1) += 1;
+  cv.labels(std::string_view("foo"), 1) += 2;
+  cv.labels("foo", 1) += 4;
+  cv.labels("foo", 2) += 8;
+
+  CHECK_EQUAL(7.0, *cv.labels(foo, 1));
+  CHECK_EQUAL(
+      test_collector(
+          { {"test.metric", ""} },
+          { {"test.metric{id=1, label_name=\"foo\"}", std::to_string(7.0)},
+            {"test.metric{id=2, label_name=\"foo\"}", std::to_string(8.0)}
+          }),
+      test_collector(e));
+}
+
+TEST(counter_vector_concurrent_labels) {
+  engine e;
+  counter_vector<int> cv(e, "test.metric", {"label_name"});
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back(
+        [cv]() mutable {
+          for (int j = 0; j < 100; ++j) ++cv.labels(j);
+        });
+  }
+  for (auto& t : threads) t.join();
+
+  const test_collector tc(e);
+  CHECK_EQUAL(100u, tc.metrics.size());
+  for (int j = 0; j < 100; ++j)
+    CHECK_EQUAL(8.0, *cv.labels(j));
+}
+
+TEST(counter_vector_expire_after_scrapes) {
+  engine e;
+  counter_vector<std::string> cv(e, "test.metric", {"label_name"}, "this is a test");
+  cv.expire(expiry::after_scrapes(1));
+  const counter held = cv.labels("held");
+  cv.labels("idle") += 1;
+  cv.labels("busy") += 1;
+
+  test_collector first(e);
+  CHECK_EQUAL(0u, cv.expired());
+  CHECK_EQUAL(3u, first.metrics.size());
+
+  cv.labels("busy") += 1;
+  CHECK_EQUAL(
+      test_collector(
+          { {"test.metric", "this is a test"} },
+          { {"test.metric{label_name=\"held\"}", std::to_string(0.0)},
+            {"test.metric{label_name=\"busy\"}", std::to_string(2.0)}
+          }),
+      test_collector(e));
+  CHECK_EQUAL(1u, cv.expired());
+
+  // An expired series starts over.
+  CHECK_EQUAL(0.0, *cv.labels("idle"));
+}
+
+TEST(counter_vector_expire_ignores_changed_collections) {
+  engine e;
+  counter_vector<std::string> cv(e, "test.metric", {"label_name"}, "this is a test");
+  cv.expire(expiry::after_scrapes(1));
+  cv.labels("idle") += 1;
+
+  // Collecting changes doesn't count as a scrape.
+  engine::cursor cur;
+  for (int i = 0; i < 5; ++i) {
+    test_collector tc;
+    e.collect_changed(tc, cur);
+  }
+  CHECK_EQUAL(0u, cv.expired());
+
+  test_collector first(e);
+  CHECK_EQUAL(0u, cv.expired());
+  CHECK_EQUAL(1u, first.metrics.size());
+
+  test_collector second(e);
+  CHECK_EQUAL(1u, cv.expired());
+  CHECK_EQUAL(0u, second.metrics.size());
+}
+
+TEST(counter_vector_expire_after_duration) {
+  using namespace std::chrono_literals;
+
+  engine e;
+  counter_vector<std::string> cv(e, "test.metric", {"label_name"}, "this is a test");
+  cv.expire(expiry::after(1ms));
+  cv.labels("idle") += 1;
+
+  test_collector first(e);
+  CHECK_EQUAL(1u, first.metrics.size());
+
+  std::this_thread::sleep_for(2ms);
+  CHECK_EQUAL(0u, test_collector(e).metrics.size());
+  CHECK_EQUAL(1u, cv.expired());
+}
+
+TEST(counter_vector_expire_many) {
+  engine e;
+  counter_vector<int> cv(e, "test.metric", {"label_name"}, "this is a test");
+  cv.expire(expiry::after_scrapes(1));
+
+  // Handles keep the even series alive, while the odd ones expire.
+  std::vector<counter> held;
+  std::multimap<std::string, std::string> expected;
+  for (int i = 0; i < 1000; ++i) {
+    cv.labels(i) += i;
+    if (i % 2 == 0) {
+      held.push_back(cv.labels(i));
+      expected.emplace("test.metric{label_name=" + std::to_string(i) + "}", std::to_string(double(i)));
+    }
+  }
+
+  test_collector first(e);
+  CHECK_EQUAL(
+      test_collector({ {"test.metric", "this is a test"} }, expected),
+      test_collector(e));
+  CHECK_EQUAL(500u, cv.expired());
+
+  // The remaining series can still be found.
+  for (int i = 0; i < 1000; i += 2) CHECK_EQUAL(double(i), *cv.labels(i));
+}
+
+TEST(counter_vector_limit_series) {
+  engine e;
+  counter_vector<std::string, int> cv(e, "test.metric", {"name", "id"}, "this is a test");
+  cv.limit_series(2);
+  cv.labels("foo", 1) += 1;
+  cv.labels("bar", 2) += 2;
+  cv.labels("baz", 3) += 3;
+  cv.labels("baz", 4) += 4;
+  cv.labels("foo", 1) += 1;
+
+  CHECK_EQUAL(
+      test_collector(
+          { {"test.metric", "this is a test"} },
+          { {"test.metric{id=1, name=\"foo\"}", std::to_string(2.0)},
+            {"test.metric{id=2, name=\"bar\"}", std::to_string(2.0)},
+            {"test.metric{id=\"__overflow__\", name=\"__overflow__\"}", std::to_string(7.0)}
+          }),
+      test_collector(e));
+  CHECK_EQUAL(2u, cv.dropped());
+}
+
+TEST(counter_vector_limit_series_existing_lookup) {
+  engine e;
+  counter_vector<int> cv(e, "test.metric", {"label_name"}, "this is a test");
+  cv.limit_series(1);
+  cv.labels(1) += 1;
+
+  // Looking up a series that exists is not dropped, once the limit is reached.
+  cv.labels(1) += 1;
+  CHECK_EQUAL(2.0, *cv.labels(1));
+  CHECK_EQUAL(0u, cv.dropped());
+
+  cv.labels(2) += 1;
+  CHECK_EQUAL(1u, cv.dropped());
+  CHECK_EQUAL(2.0, *cv.labels(1));
+  CHECK_EQUAL(1u, cv.dropped());
+}
+
+TEST(counter_vector_limit_series_with_expiry) {
+  engine e;
+  counter_vector<int> cv(e, "test.metric", {"label_name"}, "this is a test");
+  cv.limit_series(1);
+  cv.expire(expiry::after_scrapes(1));
+  cv.labels(1) += 1;
+
+  // Once the first series expires, there is room for a new series.
+  test_collector first(e);
+  test_collector second(e);
+  CHECK_EQUAL(1u, cv.expired());
+  cv.labels(2) += 2;
+
+  CHECK_EQUAL(
+      test_collector(
+          { {"test.metric", "this is a test"} },
+          { {"test.metric{label_name=2}", std::to_string(2.0)} }),
+      test_collector(e));
+  CHECK_EQUAL(0u, cv.dropped());
+}
+
+TEST(expiry_rejects_empty_policy) {
+  CHECK_THROW(expiry::after_scrapes(0), std::logic_error);
+  CHECK_THROW(expiry::after(std::chrono::seconds(0)), std::logic_error);
+}
+
 int main() {
   return UnitTest::RunAllTests();
 }
@@ -0,0 +1,71 @@
+#include <instrumentation/counter_u64.h>
+#include <instrumentation/engine.h>
+#include <UnitTest++/UnitTest++.h>
+#include "test_collector.h"
+#include <cstdint>
+#include <string>
+
+using namespace instrumentation;
+
+TEST(default_constructor_creates_no_metric) {
+  counter_u64_vector<> cv;
+  counter_u64 c = cv.labels();
+
+  CHECK_EQUAL(true, !cv);
+  CHECK_EQUAL(false, bool(cv));
+
+  CHECK_EQUAL(true, !c);
+  CHECK_EQUAL(false, bool(c));
+
+  CHECK_EQUAL(0u, *c);
+}
+
+TEST(no_metric_counter_ops_have_no_effect) {
+  counter_u64 c;
+
+  REQUIRE CHECK_EQUAL(0u, *c);
+  ++c;
+  CHECK_EQUAL(0u, *c);
+}
+
+TEST(counter_ops) {
+  engine e;
+  counter_u64 c = counter_u64_vector<>(e, "test.metric", {}).labels();
+
+  REQUIRE CHECK_EQUAL(0u, *c);
+  ++c;
+  CHECK_EQUAL(1u, *c);
+  c++;
+  CHECK_EQUAL(2u, *c);
+  c += 17;
+  CHECK_EQUAL(19u, *c);
+}
+
+TEST(counter_is_exact_above_2_pow_53) {
+  engine e;
+  counter_u64 c = counter_u64_vector<>(e, "test.metric", {}).labels();
+
+  c += std::uint64_t(1) << 53;
+  ++c;
+  CHECK_EQUAL((std::uint64_t(1) << 53) + 1u, *c);
+}
+
+TEST(counter_vector) {
+  engine e;
+  counter_u64_vector<std::string> cv(e, "test.metric", {"label_name"}, "this is a test");
+
+  cv.labels("foo") += 11;
+  cv.labels("bar") += 17;
+
+  CHECK_EQUAL(
+      test_collector(
+          { {"test.metric", "this is a test"} },
+          { {"test.metric{label_name=\"foo\"}", std::to_string(11)},
+            {"test.metric{label_name=\"bar\"}", std::to_string(17)}
+          }),
+      test_collector(e));
+}
+
+int main() {
+  return UnitTest::RunAllTests();
+}
@@ -0,0 +1,188 @@
+#include <instrumentation/engine.h>
+#include <instrumentation/counter.h>
+#include <instrumentation/gauge.h>
+#include <instrumentation/timing.h>
+#include <instrumentation/collector.h>
+#include <UnitTest++/UnitTest++.h>
+#include "test_collector.h"
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace instrumentation;
+
+namespace {
+
+// Forwards to a test_collector, invoking a callback before each metric is visited.
+class callback_collector final
+: public collector
+{
+  public:
+  explicit callback_collector(std::function<void()> cb)
+  : cb(std::move(cb))
+  {}
+
+  void visit_description(const metric_name& n, std::string_view description) override {
+    tc.visit_description(n, description);
+  }
+
+  void visit(const metric_name& n, const tags& t, const counter& m) override { cb(); tc.visit(n, t, m); }
+  void visit(const metric_name& n, const tags& t, const counter_u64& m) override { cb(); tc.visit(n, t, m); }
+  void visit(const metric_name& n, const tags& t, const gauge& m) override { cb(); tc.visit(n, t, m); }
+  void visit(const metric_name& n, const tags& t, const gauge_i64& m) override { cb(); tc.visit(n, t, m); }
+  void visit(const metric_name& n, const tags& t, const string& m) override { cb(); tc.visit(n, t, m); }
+  void visit(const metric_name& n, const tags& t, const timing& m) override { cb(); tc.visit(n, t, m); }
+  void visit(const metric_name& n, const tags& t, const summary& m) override { cb(); tc.visit(n, t, m); }
+
+  std::function<void()> cb;
+  test_collector tc;
+};
+
+} /* namespace <unnamed> */
+
+TEST(collect_changed_first_visits_all) {
+  engine e;
+  counter_vector<std::string> cv(e, "test.counter", {"label_name"}, "counter");
+  gauge_vector<> gv(e, "test.gauge", {}, "gauge");
+  cv.labels("foo") += 1;
+  cv.labels("bar");
+  gv.labels();
+
+  engine::cursor cur;
+  test_collector tc;
+  e.collect_changed(tc, cur);
+
+  CHECK_EQUAL(test_collector(e), tc);
+}
+
+TEST(collect_changed_visits_modified) {
+  using namespace std::chrono_literals;
+
+  engine e;
+  counter_vector<std::string> cv(e, "test.counter", {"label_name"}, "counter");
+  gauge_vector<> gv(e, "test.gauge", {}, "gauge");
+  timing_vector<> tv(e, "test.timing", {}, {1s}, "timing");
+  cv.labels("foo") += 1;
+  cv.labels("bar") += 2;
+  gv.labels() = 3;
+  tv.labels() << 1ms;
+
+  engine::cursor cur;
+  test_collector initial;
+  e.collect_changed(initial, cur);
+  // Series modified in the previous generation may be visited once more.
+  test_collector repeat;
+  e.collect_changed(repeat, cur);
+
+  cv.labels("foo") += 4;
+  cv.labels("baz");
+
+  test_collector tc;
+  e.collect_changed(tc, cur);
+  CHECK_EQUAL(
+      test_collector(
+          { {"test.counter", "counter"} },
+          { {"test.counter{label_name=\"foo\"}", std::to_string(5.0)},
+            {"test.counter{label_name=\"baz\"}", std::to_string(0.0)}
+          }),
+      tc);
+}
+
+TEST(collect_changed_nothing_modified) {
+  engine e;
+  counter_vector<> cv(e, "test.counter", {}, "counter");
+  cv.labels() += 1;
+
+  engine::cursor cur;
+  test_collector initial;
+  e.collect_changed(initial, cur);
+  test_collector repeat;
+  e.collect_changed(repeat, cur);
+
+  test_collector tc;
+  e.collect_changed(tc, cur);
+  CHECK_EQUAL(test_collector(), tc);
+}
+
+TEST(collect_changed_independent_cursors) {
+  engine e;
+  counter_vector<> cv(e, "test.counter", {}, "counter");
+  cv.labels() += 1;
+
+  engine::cursor a, b;
+  test_collector tc_a1, tc_a2, tc_a3;
+  e.collect_changed(tc_a1, a);
+  e.collect_changed(tc_a2, a);
+  e.collect_changed(tc_a3, a);
+  CHECK_EQUAL(test_collector(), tc_a3);
+
+  // A fresh cursor still sees everything.
+  test_collector tc_b;
+  e.collect_changed(tc_b, b);
+  CHECK_EQUAL(test_collector(e), tc_b);
+}
+
+TEST(collect_parallel_matches_collect) {
+  engine e;
+  counter_vector<int> cv(e, "test.counter", {"label_name"}, "counter");
+  gauge_vector<> gv1(e, "test.gauge1", {}, "gauge");
+  gauge_vector<> gv2(e, "test.gauge2", {}, "gauge");
+  for (int i = 0; i < 10; ++i) cv.labels(i) += i;
+  gv1.labels() = 1;
+  gv2.labels() = 2;
+
+  std::vector<test_collector> tcs(5);
+  std::vector<collector*> collectors;
+  for (auto& tc : tcs) collectors.push_back(&tc);
+  e.collect_parallel(collectors, 3);
+
+  test_collector merged;
+  for (const auto& tc : tcs) {
+    merged.descriptions.insert(tc.descriptions.begin(), tc.descriptions.end());
+    merged.metrics.insert(tc.metrics.begin(), tc.metrics.end());
+  }
+  CHECK_EQUAL(test_collector(e), merged);
+}
+
+TEST(collect_parallel_no_collectors) {
+  engine e;
+  gauge_vector<> gv(e, "test.gauge", {}, "gauge");
+  e.collect_parallel({}, 4);
+}
+
+TEST(collect_holds_no_locks_while_visiting) {
+  engine e;
+  counter_vector<int> cv(e, "test.counter", {"label_name"}, "counter");
+  cv.labels(0) += 1;
+
+  // Creating metrics and series from within the collector requires the exclusive locks,
+  // which would deadlock if collection held them.
+  int calls = 0;
+  callback_collector c(
+      [&]() {
+        ++calls;
+        cv.labels(calls) += 1;
+        gauge_vector<>(e, "test.gauge" + std::to_string(calls), {}, "gauge").labels() = calls;
+      });
+  e.collect(c);
+
+  CHECK_EQUAL(1, calls);
+  CHECK_EQUAL(
+      test_collector(
+          {
+            {"test.counter", "counter"},
+          },
+          {
+            {"test.counter{label_name=0}", std::to_string(1.0)},
+          }),
+      c.tc);
+
+  const test_collector after(e);
+  CHECK_EQUAL(1u, after.metrics.count("test.counter{label_name=1}"));
+  CHECK_EQUAL(1u, after.metrics.count("test.gauge1{}"));
+}
+
+int main() {
+  return UnitTest::RunAllTests();
+}
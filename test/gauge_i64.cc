@@ -0,0 +1,70 @@
+#include <instrumentation/gauge_i64.h>
+#include <instrumentation/engine.h>
+#include <UnitTest++/UnitTest++.h>
+#include "test_collector.h"
+#include <cstdint>
+#include <string>
+
+using namespace instrumentation;
+
+TEST(default_constructor_creates_no_metric) {
+  gauge_i64_vector<> gv;
+  gauge_i64 g = gv.labels();
+
+  CHECK_EQUAL(true, !gv);
+  CHECK_EQUAL(false, bool(gv));
+
+  CHECK_EQUAL(true, !g);
+  CHECK_EQUAL(false, bool(g));
+
+  CHECK_EQUAL(0, *g);
+}
+
+TEST(no_metric_gauge_ops_have_no_effect) {
+  gauge_i64 g;
+
+  REQUIRE CHECK_EQUAL(0, *g);
+  ++g;
+  CHECK_EQUAL(0, *g);
+}
+
+TEST(gauge_ops) {
+  engine e;
+  gauge_i64 g = gauge_i64_vector<>(e, "test.metric", {}).labels();
+
+  REQUIRE CHECK_EQUAL(0, *g);
+  ++g;
+  CHECK_EQUAL(1, *g);
+  g++;
+  CHECK_EQUAL(2, *g);
+  g += 17;
+  CHECK_EQUAL(19, *g);
+  --g;
+  CHECK_EQUAL(18, *g);
+  g--;
+  CHECK_EQUAL(17, *g);
+  g -= 20;
+  CHECK_EQUAL(-3, *g);
+  g = 42;
+  CHECK_EQUAL(42, *g);
+}
+
+TEST(gauge_vector) {
+  engine e;
+  gauge_i64_vector<std::string> gv(e, "test.metric", {"label_name"}, "this is a test");
+
+  gv.labels("foo") += 11;
+  gv.labels("bar") -= 17;
+
+  CHECK_EQUAL(
+      test_collector(
+          { {"test.metric", "this is a test"} },
+          { {"test.metric{label_name=\"foo\"}", std::to_string(11)},
+            {"test.metric{label_name=\"bar\"}", std::to_string(-17)}
+          }),
+      test_collector(e));
+}
+
+int main() {
+  return UnitTest::RunAllTests();
+}
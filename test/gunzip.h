@@ -0,0 +1,39 @@
+#ifndef GUNZIP_H
+#define GUNZIP_H
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#ifdef HAVE_ZLIB
+# include <zlib.h>
+#endif
+
+///\brief Decompress a gzip stream.
+inline auto gunzip(std::string_view in) -> std::string {
+#ifdef HAVE_ZLIB
+  z_stream strm{};
+  if (inflateInit2(&strm, 15 + 16) != Z_OK) throw std::runtime_error("inflateInit2 failed");
+  strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+  strm.avail_in = static_cast<uInt>(in.size());
+
+  std::string out;
+  int rv;
+  do {
+    char buf[16384];
+    strm.next_out = reinterpret_cast<Bytef*>(buf);
+    strm.avail_out = sizeof(buf);
+    rv = inflate(&strm, Z_NO_FLUSH);
+    out.append(buf, sizeof(buf) - strm.avail_out);
+  } while (rv == Z_OK);
+  const bool complete = (rv == Z_STREAM_END && strm.avail_in == 0u);
+  inflateEnd(&strm);
+
+  if (!complete) throw std::runtime_error("invalid gzip stream");
+  return out;
+#else
+  throw std::logic_error("test was built without zlib");
+#endif
+}
+
+#endif /* GUNZIP_H */
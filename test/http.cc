@@ -0,0 +1,374 @@
+#include <instrumentation/http.h>
+#include <instrumentation/prometheus.h>
+#include <instrumentation/engine.h>
+#include <instrumentation/counter.h>
+#include <UnitTest++/UnitTest++.h>
+#include "gunzip.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace instrumentation;
+
+namespace {
+
+
+// Blocking loopback client.
+class client {
+  public:
+  explicit client(std::uint16_t port)
+  : fd_(::socket(AF_INET, SOCK_STREAM, 0))
+  {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == -1)
+      throw std::runtime_error("connect failed");
+  }
+
+  explicit client(const std::string& path)
+  : fd_(::socket(AF_UNIX, SOCK_STREAM, 0))
+  {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.data(), path.size());
+    if (::connect(fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == -1)
+      throw std::runtime_error("connect failed");
+  }
+
+  client(const client&) = delete;
+  ~client() { ::close(fd_); }
+
+  void send(std::string_view request) {
+    while (!request.empty()) {
+      const auto wlen = ::send(fd_, request.data(), request.size(), MSG_NOSIGNAL);
+      if (wlen <= 0) throw std::runtime_error("send failed");
+      request.remove_prefix(wlen);
+    }
+  }
+
+  // Read one response. Returns the head, and stores the body in body.
+  auto read_response(std::string& body, bool head_only = false) -> std::string {
+    std::size_t end;
+    while ((end = buf_.find("\r\n\r\n")) == std::string::npos) fill_();
+    std::string head = buf_.substr(0, end + 4u);
+    buf_.erase(0, end + 4u);
+
+    std::size_t len = 0;
+    if (!head_only) {
+      const auto cl = head.find("Content-Length: ");
+      if (cl != std::string::npos) len = std::stoul(head.substr(cl + 16u));
+    }
+    while (buf_.size() < len) fill_();
+    body = buf_.substr(0, len);
+    buf_.erase(0, len);
+    return head;
+  }
+
+  // Test if the server closed the connection.
+  auto closed() -> bool {
+    char c;
+    return buf_.empty() && ::recv(fd_, &c, 1, 0) == 0;
+  }
+
+  private:
+  void fill_() {
+    char tmp[4096];
+    const auto rlen = ::recv(fd_, tmp, sizeof(tmp), 0);
+    if (rlen <= 0) throw std::runtime_error("connection closed");
+    buf_.append(tmp, rlen);
+  }
+
+  int fd_;
+  std::string buf_;
+};
+
+auto status_line(const std::string& head) -> std::string {
+  return head.substr(0, head.find("\r\n"));
+}
+
+auto has_header(const std::string& head, std::string_view header) -> bool {
+  return head.find(std::string("\r\n") + std::string(header) + "\r\n") != std::string::npos;
+}
+
+
+} /* namespace <unnamed> */
+
+TEST(http_get_metrics) {
+  engine e;
+  counter_vector<std::string> mv(e, "test.metric", {"label_name"}, "this is a test");
+  mv.labels("foo") += 11;
+
+  const auto exporter = http_exporter::tcp(e, "127.0.0.1", 0);
+  CHECK(exporter.port() != 0u);
+
+  client c(exporter.port());
+  c.send("GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  std::string body;
+  const std::string head = c.read_response(body);
+
+  CHECK_EQUAL("HTTP/1.1 200 OK", status_line(head));
+  CHECK(has_header(head, "Content-Type: " + std::string(prometheus_content_type)));
+  CHECK(has_header(head, "Connection: keep-alive"));
+  CHECK_EQUAL(collect_prometheus(e), body);
+}
+
+TEST(http_protobuf) {
+  engine e;
+  counter_vector<std::string> mv(e, "test.metric", {"label_name"}, "this is a test");
+  mv.labels("foo") += 11;
+
+  const auto exporter = http_exporter::tcp(e, "127.0.0.1", 0);
+  client c(exporter.port());
+  c.send("GET /metrics HTTP/1.1\r\nAccept: application/vnd.google.protobuf;proto=io.prometheus.client.MetricFamily;encoding=delimited;q=0.7,text/plain;version=0.0.4;q=0.3\r\n\r\n");
+  std::string body;
+  const std::string head = c.read_response(body);
+
+  CHECK_EQUAL("HTTP/1.1 200 OK", status_line(head));
+  CHECK(has_header(head, "Content-Type: " + std::string(prometheus_protobuf_content_type)));
+  CHECK_EQUAL(collect_prometheus_protobuf(e), body);
+}
+
+TEST(http_accept_media_type) {
+  engine e;
+  counter_vector<std::string> mv(e, "test.metric", {"label_name"}, "this is a test");
+  mv.labels("foo") += 11;
+
+  const auto exporter = http_exporter::tcp(e, "127.0.0.1", 0);
+  client c(exporter.port());
+  std::string body;
+
+  // Only the media type selects protobuf, not a parameter or a longer type that contains it.
+  c.send("GET /metrics HTTP/1.1\r\nAccept: text/plain;note=application/vnd.google.protobuf\r\n\r\n");
+  CHECK(has_header(c.read_response(body), "Content-Type: " + std::string(prometheus_content_type)));
+  c.send("GET /metrics HTTP/1.1\r\nAccept: application/vnd.google.protobuf-other\r\n\r\n");
+  CHECK(has_header(c.read_response(body), "Content-Type: " + std::string(prometheus_content_type)));
+  c.send("GET /metrics HTTP/1.1\r\nAccept: text/plain, Application/Vnd.Google.Protobuf;encoding=delimited\r\n\r\n");
+  CHECK(has_header(c.read_response(body), "Content-Type: " + std::string(prometheus_protobuf_content_type)));
+}
+
+TEST(http_gzip) {
+  engine e;
+  counter_vector<int> mv(e, "test.metric", {"idx"}, "this is a test");
+  for (int i = 0; i < 1000; ++i) mv.labels(i) += i;
+
+  const auto exporter = http_exporter::tcp(e, "127.0.0.1", 0);
+  client c(exporter.port());
+  c.send("GET /metrics HTTP/1.1\r\nAccept-Encoding: deflate, gzip;q=1.0\r\n\r\n");
+  std::string body;
+  const std::string head = c.read_response(body);
+
+  CHECK_EQUAL("HTTP/1.1 200 OK", status_line(head));
+  CHECK(has_header(head, "Vary: Accept, Accept-Encoding"));
+  if (prometheus_gzip_supported()) {
+    CHECK(has_header(head, "Content-Encoding: gzip"));
+    CHECK_EQUAL(collect_prometheus(e), gunzip(body));
+  } else {
+    CHECK(head.find("Content-Encoding") == std::string::npos);
+    CHECK_EQUAL(collect_prometheus(e), body);
+  }
+
+  // Clients that don't ask for gzip get the uncompressed text.
+  c.send("GET /metrics HTTP/1.1\r\n\r\n");
+  const std::string identity_head = c.read_response(body);
+  CHECK(identity_head.find("Content-Encoding") == std::string::npos);
+  CHECK(has_header(identity_head, "Vary: Accept, Accept-Encoding"));
+  CHECK_EQUAL(collect_prometheus(e), body);
+}
+
+TEST(http_pipelined_requests) {
+  engine e;
+  counter_vector<> mv(e, "test.metric", {}, "this is a test");
+  mv.labels() += 1;
+
+  const auto exporter = http_exporter::tcp(e, "127.0.0.1", 0);
+  client c(exporter.port());
+  c.send(
+      "GET /metrics HTTP/1.1\r\n\r\n"
+      "GET /other HTTP/1.1\r\n\r\n"
+      "HEAD /metrics?x=y HTTP/1.1\r\n\r\n"
+      "POST /metrics HTTP/1.1\r\nContent-Length: 0\r\n\r\n");
+
+  std::string body;
+  CHECK_EQUAL("HTTP/1.1 200 OK", status_line(c.read_response(body)));
+  CHECK_EQUAL(collect_prometheus(e), body);
+  CHECK_EQUAL("HTTP/1.1 404 Not Found", status_line(c.read_response(body)));
+  CHECK_EQUAL("HTTP/1.1 200 OK", status_line(c.read_response(body, true)));
+  CHECK_EQUAL("", body);
+  const std::string head = c.read_response(body);
+  CHECK_EQUAL("HTTP/1.1 405 Method Not Allowed", status_line(head));
+  CHECK(has_header(head, "Allow: GET, HEAD"));
+}
+
+TEST(http_connection_close) {
+  engine e;
+  const auto exporter = http_exporter::tcp(e, "127.0.0.1", 0);
+
+  {
+    client c(exporter.port());
+    c.send("GET /metrics HTTP/1.0\r\n\r\n");
+    std::string body;
+    CHECK(has_header(c.read_response(body), "Connection: close"));
+    CHECK(c.closed());
+  }
+
+  {
+    client c(exporter.port());
+    c.send("GET /metrics HTTP/1.1\r\nConnection: close\r\n\r\n");
+    std::string body;
+    CHECK(has_header(c.read_response(body), "Connection: close"));
+    CHECK(c.closed());
+  }
+
+  {
+    client c(exporter.port());
+    c.send("garbage\r\n\r\n");
+    std::string body;
+    CHECK_EQUAL("HTTP/1.1 400 Bad Request", status_line(c.read_response(body)));
+    CHECK(c.closed());
+  }
+}
+
+TEST(http_response_reused_within_max_age) {
+  engine e;
+  counter_vector<> mv(e, "test.metric", {}, "this is a test");
+  mv.labels() += 1;
+
+  http_options opts;
+  opts.max_age = std::chrono::hours(1);
+  const auto exporter = http_exporter::tcp(e, "127.0.0.1", 0, opts);
+
+  client c1(exporter.port());
+  client c2(exporter.port());
+  std::string body1, body2;
+  c1.send("GET /metrics HTTP/1.1\r\n\r\n");
+  c1.read_response(body1);
+  mv.labels() += 1;
+  c2.send("GET /metrics HTTP/1.1\r\n\r\n");
+  c2.read_response(body2);
+
+  CHECK_EQUAL(body1, body2);
+  CHECK(body2 != collect_prometheus(e));
+}
+
+TEST(http_response_rendered_for_each_scrape) {
+  engine e;
+  counter_vector<> mv(e, "test.metric", {}, "this is a test");
+  mv.labels() += 1;
+
+  http_options opts;
+  opts.max_age = std::chrono::milliseconds(0);
+  const auto exporter = http_exporter::tcp(e, "127.0.0.1", 0, opts);
+
+  client c(exporter.port());
+  std::string body;
+  for (int i = 0; i < 3; ++i) {
+    mv.labels() += 1;
+    c.send("GET /metrics HTTP/1.1\r\n\r\n");
+    c.read_response(body);
+    CHECK_EQUAL(collect_prometheus(e), body);
+  }
+}
+
+TEST(http_large_response) {
+  engine e;
+  counter_vector<int> mv(e, "test.metric", {"idx"}, "this is a test");
+  for (int i = 0; i < 50000; ++i) mv.labels(i) += 1;
+
+  const auto exporter = http_exporter::tcp(e, "127.0.0.1", 0);
+  std::vector<std::unique_ptr<client>> clients;
+  for (int i = 0; i < 4; ++i) {
+    clients.push_back(std::make_unique<client>(exporter.port()));
+    clients.back()->send("GET /metrics HTTP/1.1\r\n\r\n");
+  }
+
+  const std::string expect = collect_prometheus(e);
+  for (const auto& c : clients) {
+    std::string body;
+    c->read_response(body);
+    CHECK(body == expect);
+  }
+}
+
+TEST(http_unix_socket) {
+  engine e;
+  counter_vector<> mv(e, "test.metric", {}, "this is a test");
+  mv.labels() += 1;
+
+  const std::string path = "test_http_" + std::to_string(::getpid()) + ".sock";
+  {
+    const auto exporter = http_exporter::unix_socket(e, path);
+    CHECK_EQUAL(0u, exporter.port());
+
+    client c(path);
+    c.send("GET /metrics HTTP/1.1\r\n\r\n");
+    std::string body;
+    CHECK_EQUAL("HTTP/1.1 200 OK", status_line(c.read_response(body)));
+    CHECK_EQUAL(collect_prometheus(e), body);
+  }
+  CHECK(::access(path.c_str(), F_OK) != 0);
+}
+
+TEST(http_out_of_descriptors) {
+  engine e;
+  const auto exporter = http_exporter::tcp(e, "127.0.0.1", 0);
+
+  // Create the client socket up front: connecting doesn't need another descriptor.
+  const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  const timeval timeout{ 5, 0 };
+  ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  // Use up all descriptors, under a low limit.
+  rlimit saved;
+  ::getrlimit(RLIMIT_NOFILE, &saved);
+  rlimit low = saved;
+  low.rlim_cur = std::min<rlim_t>(saved.rlim_cur, 256u);
+  ::setrlimit(RLIMIT_NOFILE, &low);
+  std::vector<int> fillers;
+  for (int f; (f = ::open("/dev/null", O_RDONLY)) != -1; ) fillers.push_back(f);
+
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(exporter.port());
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  CHECK(::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0);
+
+  // The server can't keep the connection, so it closes it instead of leaving it pending.
+  char c;
+  CHECK_EQUAL(0, ::recv(fd, &c, 1, 0));
+  ::close(fd);
+
+  for (int f : fillers) ::close(f);
+  ::setrlimit(RLIMIT_NOFILE, &saved);
+
+  // Once descriptors are available, connections are served again.
+  client cl(exporter.port());
+  cl.send("GET /metrics HTTP/1.1\r\n\r\n");
+  std::string body;
+  CHECK_EQUAL("HTTP/1.1 200 OK", status_line(cl.read_response(body)));
+}
+
+TEST(http_invalid_address) {
+  engine e;
+  CHECK_THROW(http_exporter::tcp(e, "localhost", 0), std::invalid_argument);
+}
+
+int main() {
+  return UnitTest::RunAllTests();
+}
@@ -0,0 +1,74 @@
+#include <instrumentation/interned_string.h>
+#include <instrumentation/counter.h>
+#include <instrumentation/engine.h>
+#include <instrumentation/prometheus.h>
+#include <UnitTest++/UnitTest++.h>
+#include "test_collector.h"
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace instrumentation;
+
+TEST(empty_interned_string) {
+  CHECK_EQUAL(true, interned_string().empty());
+  CHECK(interned_string() == interned_string(""));
+  CHECK_EQUAL("", interned_string().view());
+  CHECK_EQUAL(detail::hash_bytes(""), interned_string().hash());
+}
+
+TEST(interned_string_equality) {
+  const std::string s = "GET";
+  const interned_string x(s);
+  const interned_string y("GET");
+
+  CHECK(x == y);
+  CHECK(x != interned_string("POST"));
+  CHECK_EQUAL("GET", x.view());
+  CHECK(x.view().data() == y.view().data());
+  CHECK_EQUAL(detail::hash_bytes("GET"), x.hash());
+}
+
+TEST(interned_string_concurrent) {
+  constexpr int num_threads = 4;
+  std::vector<std::vector<interned_string>> results(num_threads);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back(
+        [&results, t]() {
+          for (int i = 0; i < 1000; ++i) results[t].emplace_back("concurrent." + std::to_string(i));
+        });
+  }
+  for (auto& thr : threads) thr.join();
+
+  for (int t = 1; t < num_threads; ++t) CHECK(results[0] == results[t]);
+}
+
+TEST(interned_string_label) {
+  engine e;
+  counter_vector<interned_string, int> cv(e, "test.metric", {"method", "status"}, "this is a test");
+  const interned_string get = "GET";
+  cv.labels(get, 200) += 1;
+  cv.labels("GET", 200) += 1;
+  cv.labels("POST", 500) += 1;
+
+  CHECK_EQUAL(
+      test_collector(
+          { {"test.metric", "this is a test"} },
+          { {"test.metric{method=\"GET\", status=200}", std::to_string(2.0)},
+            {"test.metric{method=\"POST\", status=500}", std::to_string(1.0)}
+          }),
+      test_collector(e));
+
+  // Renders the same as a string label.
+  engine e2;
+  counter_vector<std::string, int> sv(e2, "test.metric", {"method", "status"}, "this is a test");
+  sv.labels("GET", 200) += 2;
+  sv.labels("POST", 500) += 1;
+  CHECK_EQUAL(collect_prometheus(e2), collect_prometheus(e));
+}
+
+int main() {
+  return UnitTest::RunAllTests();
+}
@@ -0,0 +1,52 @@
+#include <instrumentation/metric_name.h>
+#include <UnitTest++/UnitTest++.h>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace instrumentation;
+
+TEST(empty_name) {
+  CHECK_EQUAL(true, metric_name().empty());
+  CHECK_EQUAL(true, metric_name("").empty());
+  CHECK(metric_name() == metric_name(""));
+  CHECK_EQUAL(0u, metric_name().elements().size());
+}
+
+TEST(name_from_path) {
+  const metric_name n("http.server.requests");
+
+  CHECK_EQUAL("http.server.requests", n.path());
+  CHECK_EQUAL("http_server_requests", n.with_separator("_"));
+  CHECK_EQUAL("http::server::requests", n.with_separator("::"));
+  CHECK(n.elements() == std::vector<std::string_view>({ "http", "server", "requests" }));
+}
+
+TEST(name_from_elements) {
+  CHECK(metric_name({ "http", "server", "requests" }) == metric_name("http.server.requests"));
+  CHECK(metric_name({ "http", "server" }) != metric_name("http.server.requests"));
+}
+
+TEST(interned_names_share_path) {
+  const std::string s = "test.interned";
+  const metric_name x(s);
+  const metric_name y(std::string_view("test.interned"));
+
+  CHECK(x == y);
+  CHECK(x.path().data() == y.path().data());
+  CHECK(x.path().data() != s.data());
+}
+
+TEST(literal_name) {
+  constexpr metric_name n = "http.server.requests"_metric;
+  static_assert(n.hash() == detail::hash_bytes("http.server.requests"));
+
+  CHECK(n == metric_name("http.server.requests"));
+  CHECK(n != metric_name("http.server"));
+  CHECK_EQUAL(std::hash<metric_name>()(metric_name("http.server.requests")), std::hash<metric_name>()(n));
+}
+
+int main() {
+  return UnitTest::RunAllTests();
+}
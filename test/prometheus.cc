@@ -1,12 +1,18 @@
 #include <instrumentation/prometheus.h>
 #include <instrumentation/engine.h>
 #include <instrumentation/counter.h>
+#include <instrumentation/counter_u64.h>
 #include <instrumentation/gauge.h>
+#include <instrumentation/gauge_i64.h>
 #include <instrumentation/string.h>
+#include <instrumentation/summary.h>
 #include <instrumentation/timing.h>
 #include <UnitTest++/UnitTest++.h>
+#include "gunzip.h"
 #include <string>
 #include <chrono>
+#include <sstream>
+#include <stdexcept>
 
 using namespace instrumentation;
 
@@ -34,6 +40,30 @@ TEST(prometheus_gauge) {
       collect_prometheus(e));
 }
 
+TEST(prometheus_counter_u64) {
+  engine e;
+  counter_u64_vector<std::string> mv(e, "test.metric", {"label_name"}, "this is a test");
+  mv.labels("foo") += (std::uint64_t(1) << 53) + 1u;
+
+  CHECK_EQUAL(std::string()
+      + "# HELP test_metric this is a test\n"
+      + "# TYPE test_metric counter\n"
+      + "test_metric\t{label_name=\"foo\",}\t9007199254740993\n",
+      collect_prometheus(e));
+}
+
+TEST(prometheus_gauge_i64) {
+  engine e;
+  gauge_i64_vector<std::string> mv(e, "test.metric", {"label_name"}, "this is a test");
+  mv.labels("foo") = -(std::int64_t(1) << 53) - 1;
+
+  CHECK_EQUAL(std::string()
+      + "# HELP test_metric this is a test\n"
+      + "# TYPE test_metric gauge\n"
+      + "test_metric\t{label_name=\"foo\",}\t-9007199254740993\n",
+      collect_prometheus(e));
+}
+
 TEST(prometheus_string) {
   engine e;
   string_vector<std::string> mv(e, "test.metric", {"label_name"}, "this is a test");
@@ -69,6 +99,55 @@ TEST(prometheus_timing) {
       collect_prometheus(e));
 }
 
+TEST(prometheus_timing_le_sorted_between_labels) {
+  using namespace std::chrono_literals;
+
+  engine e;
+  timing_vector<std::string, std::string> mv(e, "test.metric", {"a", "z"}, {1ms}, "");
+  mv.labels("x", "y") << 300us;
+
+  CHECK_EQUAL(std::string()
+      + "# TYPE test_metric histogram\n"
+      + "test_metric\t{a=\"x\",le=\"0.001\",z=\"y\",}\t1\n"
+      + "test_metric\t{a=\"x\",le=\"+Inf\",z=\"y\",}\t1\n",
+      collect_prometheus(e));
+}
+
+TEST(prometheus_timing_le_replaces_label) {
+  using namespace std::chrono_literals;
+
+  engine e;
+  timing_vector<std::string> mv(e, "test.metric", {"le"}, {1ms}, "");
+  mv.labels("x") << 300us;
+
+  CHECK_EQUAL(std::string()
+      + "# TYPE test_metric histogram\n"
+      + "test_metric\t{le=\"0.001\",}\t1\n"
+      + "test_metric\t{le=\"+Inf\",}\t1\n",
+      collect_prometheus(e));
+}
+
+TEST(prometheus_summary) {
+  using namespace std::chrono_literals;
+
+  engine e;
+  summary_vector<std::string> mv(e, "test.metric", {"label_name"}, {0.5}, 0.01, "this is a test");
+  mv.labels("foo") << 250ms << 500ms << 750ms;
+
+  const std::string expected_head = std::string()
+      + "# HELP test_metric this is a test\n"
+      + "# TYPE test_metric summary\n"
+      + "test_metric\t{label_name=\"foo\",quantile=\"0.5\",}\t0.5";
+  const std::string expected_tail = std::string()
+      + "test_metric_sum\t{label_name=\"foo\",}\t1.5\n"
+      + "test_metric_count\t{label_name=\"foo\",}\t3\n";
+
+  const std::string out = collect_prometheus(e);
+  CHECK_EQUAL(expected_head, out.substr(0, expected_head.size()));
+  REQUIRE CHECK(out.size() >= expected_tail.size());
+  CHECK_EQUAL(expected_tail, out.substr(out.size() - expected_tail.size()));
+}
+
 TEST(label_types) {
   engine e;
   counter_vector<bool, std::int64_t, double, std::string> mv(e, "test.metric", {"bool", "int", "double", "string"});
@@ -148,6 +227,67 @@ TEST(fix_label_name) {
       collect_prometheus(e));
 }
 
+TEST(fix_names_leading_digit) {
+  engine e;
+  counter_vector<std::int64_t> mv(e, "9lives.metric", {"0label"});
+  mv.labels(1);
+
+  CHECK_EQUAL(std::string()
+      + "# TYPE _lives_metric counter\n"
+      + "_lives_metric\t{_label=\"1\",}\t0\n",
+      collect_prometheus(e));
+}
+
+TEST(prometheus_parallel) {
+  using namespace std::chrono_literals;
+
+  engine e;
+  for (int i = 0; i < 50; ++i) {
+    counter_vector<int>(e, "test.counter" + std::to_string(i), {"label_name"}, "counter").labels(i) += i;
+    timing_vector<>(e, "test.timing" + std::to_string(i), {}, {1ms}, "timing").labels() << 2ms;
+  }
+
+  CHECK_EQUAL(collect_prometheus(e), collect_prometheus_parallel(e, 3));
+  CHECK_EQUAL(collect_prometheus(e), collect_prometheus_parallel(e, 1));
+}
+
+TEST(prometheus_gzip) {
+  using namespace std::chrono_literals;
+
+  engine e;
+  for (int i = 0; i < 5000; ++i) {
+    counter_vector<int>(e, "test.counter" + std::to_string(i % 50), {"label_name"}, "counter").labels(i) += i;
+    timing_vector<>(e, "test.timing" + std::to_string(i % 50), {}, {1ms}, "timing").labels() << 2ms;
+  }
+
+  if (!prometheus_gzip_supported()) {
+    CHECK_THROW(collect_prometheus_gzip(e), std::logic_error);
+    return;
+  }
+
+  const std::string expect = collect_prometheus(e);
+  const std::string compressed = collect_prometheus_gzip(e);
+  CHECK(compressed.size() < expect.size());
+  CHECK_EQUAL(expect, gunzip(compressed));
+
+  std::ostringstream oss;
+  collect_prometheus_gzip(oss, e);
+  CHECK_EQUAL(expect, gunzip(oss.str()));
+
+  // The string variant appends.
+  std::string appended = "prefix";
+  collect_prometheus_gzip(appended, e);
+  CHECK_EQUAL("prefix", appended.substr(0, 6));
+  CHECK_EQUAL(expect, gunzip(std::string_view(appended).substr(6)));
+}
+
+TEST(prometheus_gzip_empty) {
+  engine e;
+  if (!prometheus_gzip_supported()) return;
+
+  CHECK_EQUAL("", gunzip(collect_prometheus_gzip(e)));
+}
+
 int main() {
   return UnitTest::RunAllTests();
 }
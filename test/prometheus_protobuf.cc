@@ -0,0 +1,140 @@
+#include <instrumentation/prometheus.h>
+#include <instrumentation/engine.h>
+#include <instrumentation/counter.h>
+#include <instrumentation/gauge.h>
+#include <instrumentation/timing.h>
+#include <UnitTest++/UnitTest++.h>
+#include "gunzip.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+
+using namespace instrumentation;
+
+namespace {
+
+auto bytes(std::initializer_list<int> init) -> std::string {
+  std::string out;
+  for (int b : init) out.push_back(static_cast<char>(b));
+  return out;
+}
+
+auto read_varint(const std::string& s, std::size_t& pos) -> std::uint64_t {
+  std::uint64_t v = 0;
+  for (unsigned int shift = 0; ; shift += 7) {
+    const auto b = static_cast<unsigned char>(s.at(pos++));
+    v |= std::uint64_t(b & 0x7fu) << shift;
+    if ((b & 0x80u) == 0) return v;
+  }
+}
+
+} /* namespace <unnamed> */
+
+TEST(protobuf_counter) {
+  engine e;
+  counter_vector<std::string> mv(e, "test.metric", {"label_name"}, "test");
+  mv.labels("foo") += 11;
+
+  CHECK_EQUAL(std::string()
+      + bytes({ 0x35 }) // MetricFamily length
+      + bytes({ 0x0a, 0x0b }) + "test_metric"
+      + bytes({ 0x12, 0x04 }) + "test"
+      + bytes({ 0x18, 0x00 }) // COUNTER
+      + bytes({ 0x22, 0x1e }) // Metric
+      + bytes({ 0x0a, 0x11, 0x0a, 0x0a }) + "label_name" + bytes({ 0x12, 0x03 }) + "foo"
+      + bytes({ 0x1a, 0x09, 0x09, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x26, 0x40 }), // Counter{11.0}
+      collect_prometheus_protobuf(e));
+}
+
+TEST(protobuf_colliding_label_names) {
+  engine e;
+  counter_vector<std::string, std::string> mv(e, "test.metric", {"a.b", "a_b"}, "test");
+  mv.labels("x", "y") += 1;
+
+  // Both tags sanitize to a_b: only the first in name order is kept, as in the text format.
+  CHECK_EQUAL(std::string()
+      + bytes({ 0x2c }) // MetricFamily length
+      + bytes({ 0x0a, 0x0b }) + "test_metric"
+      + bytes({ 0x12, 0x04 }) + "test"
+      + bytes({ 0x18, 0x00 }) // COUNTER
+      + bytes({ 0x22, 0x15 }) // Metric
+      + bytes({ 0x0a, 0x08, 0x0a, 0x03 }) + "a_b" + bytes({ 0x12, 0x01 }) + "x"
+      + bytes({ 0x1a, 0x09, 0x09, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf0, 0x3f }), // Counter{1.0}
+      collect_prometheus_protobuf(e));
+  CHECK(collect_prometheus(e).find("{a_b=\"x\",}") != std::string::npos);
+}
+
+TEST(protobuf_histogram) {
+  using namespace std::chrono_literals;
+
+  engine e;
+  timing_vector<> mv(e, "test.metric", {}, {1ms}, "");
+  mv.labels() << 300us << 2ms;
+
+  CHECK_EQUAL(std::string()
+      + bytes({ 0x22 }) // MetricFamily length
+      + bytes({ 0x0a, 0x0b }) + "test_metric"
+      + bytes({ 0x18, 0x04 }) // HISTOGRAM
+      + bytes({ 0x22, 0x11 }) // Metric
+      + bytes({ 0x3a, 0x0f }) // Histogram
+      + bytes({ 0x08, 0x02 }) // sample_count
+      + bytes({ 0x1a, 0x0b, 0x08, 0x01, 0x11, 0xfc, 0xa9, 0xf1, 0xd2, 0x4d, 0x62, 0x50, 0x3f }), // Bucket{1, 0.001}
+      collect_prometheus_protobuf(e));
+}
+
+TEST(protobuf_long_message) {
+  engine e;
+  gauge_vector<std::string> mv(e, "test.metric", {"label_name"});
+  mv.labels(std::string(300, 'x')) = 1.0;
+  mv.labels("y") = 2.0;
+  gauge_vector<> other(e, "other", {});
+  other.labels() = 3.0;
+
+  // Walk the length-delimited families: they must cover the output exactly.
+  const std::string out = collect_prometheus_protobuf(e);
+  std::size_t pos = 0;
+  int families = 0;
+  while (pos < out.size()) {
+    const std::uint64_t len = read_varint(out, pos);
+    pos += len;
+    ++families;
+  }
+  CHECK_EQUAL(out.size(), pos);
+  CHECK_EQUAL(2, families);
+}
+
+TEST(protobuf_empty_engine) {
+  engine e;
+  CHECK_EQUAL(std::string(), collect_prometheus_protobuf(e));
+}
+
+TEST(protobuf_parallel) {
+  engine e;
+  for (int i = 0; i < 50; ++i)
+    counter_vector<int>(e, "test.counter" + std::to_string(i), {"label_name"}, "counter").labels(i) += i;
+
+  CHECK(collect_prometheus_protobuf(e) == collect_prometheus_protobuf_parallel(e, 3));
+}
+
+TEST(prometheus_protobuf_gzip) {
+  engine e;
+  for (int i = 0; i < 1000; ++i)
+    counter_vector<int>(e, "test.counter" + std::to_string(i % 10), {"label_name"}, "counter").labels(i) += i;
+
+  if (!prometheus_gzip_supported()) {
+    CHECK_THROW(collect_prometheus_protobuf_gzip(e), std::logic_error);
+    return;
+  }
+
+  const std::string expect = collect_prometheus_protobuf(e);
+  const std::string compressed = collect_prometheus_protobuf_gzip(e);
+  CHECK(compressed.size() < expect.size());
+  CHECK(expect == gunzip(compressed));
+}
+
+int main() {
+  return UnitTest::RunAllTests();
+}
@@ -0,0 +1,148 @@
+#include <instrumentation/detail/series_map.h>
+#include <UnitTest++/UnitTest++.h>
+#include <cstdint>
+#include <map>
+#include <string>
+
+using instrumentation::detail::series_map;
+
+namespace {
+
+
+using map_type = series_map<int, std::string>;
+
+// Test that find returns the value for each key, and that size matches.
+auto contains_exactly(const map_type& m, const std::map<int, std::uint64_t>& hashes) -> bool {
+  if (m.size() != hashes.size()) return false;
+  for (const auto& [key, hash] : hashes) {
+    const std::string* v = m.find(hash, key);
+    if (v == nullptr || *v != std::to_string(key)) return false;
+  }
+
+  std::size_t visited = 0;
+  m.for_each([&visited](const int& key [[maybe_unused]], const std::string& value [[maybe_unused]]) { ++visited; });
+  return visited == hashes.size();
+}
+
+
+} /* namespace <unnamed> */
+
+TEST(series_map_empty) {
+  map_type m;
+  CHECK_EQUAL(0u, m.size());
+  CHECK(m.find(42u, 1) == nullptr);
+  CHECK_EQUAL(0u, m.erase_if([](const int& key [[maybe_unused]], std::string& value [[maybe_unused]]) { return true; }));
+}
+
+TEST(series_map_colliding_hashes_wrap) {
+  // The initial table has 8 slots: all these hashes have home slot 7,
+  // so the probe sequence wraps past the end of the table.
+  const std::map<int, std::uint64_t> hashes{ {1, 7u}, {2, 15u}, {3, 23u} };
+  map_type m;
+  for (const auto& [key, hash] : hashes) m.emplace(hash, key, std::to_string(key));
+
+  CHECK(contains_exactly(m, hashes));
+  // Same hash, different key.
+  CHECK(m.find(15u, 4) == nullptr);
+  // Same key, different hash.
+  CHECK(m.find(31u, 2) == nullptr);
+}
+
+TEST(series_map_zero_hash) {
+  // Hash 0 marks an empty slot, so it is stored as a different value.
+  const std::map<int, std::uint64_t> hashes{ {1, 0u}, {2, 1u} };
+  map_type m;
+  for (const auto& [key, hash] : hashes) m.emplace(hash, key, std::to_string(key));
+
+  CHECK(contains_exactly(m, hashes));
+}
+
+TEST(series_map_erase_middle_of_probe_chain) {
+  // Keys 1, 2, 3 share home slot 1, key 4 has home slot 2 and is displaced by the chain.
+  std::map<int, std::uint64_t> hashes{ {1, 1u}, {2, 9u}, {3, 17u}, {4, 2u} };
+  map_type m;
+  for (const auto& [key, hash] : hashes) m.emplace(hash, key, std::to_string(key));
+
+  CHECK_EQUAL(1u, m.erase_if([](const int& key, std::string& value [[maybe_unused]]) { return key == 2; }));
+  hashes.erase(2);
+  CHECK(contains_exactly(m, hashes));
+
+  CHECK_EQUAL(1u, m.erase_if([](const int& key, std::string& value [[maybe_unused]]) { return key == 1; }));
+  hashes.erase(1);
+  CHECK(contains_exactly(m, hashes));
+}
+
+TEST(series_map_erase_wrapped_probe_chain) {
+  // Keys 1, 2, 3 share home slot 6 and wrap to slot 0; key 4 has home slot 0.
+  std::map<int, std::uint64_t> hashes{ {1, 6u}, {2, 14u}, {3, 22u}, {4, 8u} };
+  map_type m;
+  for (const auto& [key, hash] : hashes) m.emplace(hash, key, std::to_string(key));
+
+  CHECK_EQUAL(1u, m.erase_if([](const int& key, std::string& value [[maybe_unused]]) { return key == 1; }));
+  hashes.erase(1);
+  CHECK(contains_exactly(m, hashes));
+}
+
+TEST(series_map_erase_if_visits_each_entry_once) {
+  // Shifted entries must be visited, but only once.
+  std::map<int, std::uint64_t> hashes;
+  map_type m;
+  for (int i = 0; i < 5; ++i) {
+    hashes.emplace(i, 5u + 8u * std::uint64_t(i));
+    m.emplace(5u + 8u * std::uint64_t(i), i, std::to_string(i));
+  }
+
+  std::map<int, int> visits;
+  const auto erased = m.erase_if(
+      [&visits](const int& key, std::string& value [[maybe_unused]]) {
+        ++visits[key];
+        return key % 2 == 0;
+      });
+  CHECK_EQUAL(3u, erased);
+  CHECK_EQUAL(5u, visits.size());
+  for (const auto& [key, n] : visits) CHECK_EQUAL(1, n);
+
+  for (auto iter = hashes.begin(); iter != hashes.end(); ) {
+    if (iter->first % 2 == 0)
+      iter = hashes.erase(iter);
+    else
+      ++iter;
+  }
+  CHECK(contains_exactly(m, hashes));
+}
+
+TEST(series_map_growth) {
+  // Colliding and wrapping entries are rehashed into a larger table as the map grows.
+  std::map<int, std::uint64_t> hashes;
+  map_type m;
+  for (int i = 0; i < 1000; ++i) {
+    const std::uint64_t hash = (i % 3 == 0 ? 7u : std::uint64_t(i) * 0x9e3779b97f4a7c15u);
+    hashes.emplace(i, hash);
+    m.emplace(hash, i, std::to_string(i));
+    if (i == 5 || i == 6 || i == 12 || i == 13) CHECK(contains_exactly(m, hashes));
+  }
+  CHECK(contains_exactly(m, hashes));
+
+  // Erase and look up after growth.
+  m.erase_if([](const int& key, std::string& value [[maybe_unused]]) { return key % 2 == 0; });
+  for (auto iter = hashes.begin(); iter != hashes.end(); ) {
+    if (iter->first % 2 == 0)
+      iter = hashes.erase(iter);
+    else
+      ++iter;
+  }
+  CHECK(contains_exactly(m, hashes));
+}
+
+TEST(series_map_modify_value) {
+  map_type m;
+  m.emplace(3u, 1, "1");
+  std::string* v = m.find(3u, 1);
+  REQUIRE CHECK(v != nullptr);
+  *v = "one";
+  CHECK_EQUAL("one", *m.find(3u, 1));
+}
+
+int main() {
+  return UnitTest::RunAllTests();
+}
@@ -0,0 +1,71 @@
+#include <instrumentation/detail/small_vector.h>
+#include <UnitTest++/UnitTest++.h>
+#include <string>
+
+using instrumentation::detail::small_vector;
+
+namespace {
+
+
+// Long enough to not fit in the small string buffer.
+auto value(int i) -> std::string {
+  return "a string that is stored on the heap, number " + std::to_string(i);
+}
+
+
+} /* namespace <unnamed> */
+
+TEST(small_vector_emplace_back_grows) {
+  small_vector<std::string, 2> v;
+  for (int i = 0; i < 10; ++i) v.emplace_back(value(i));
+
+  REQUIRE CHECK_EQUAL(10u, v.size());
+  for (int i = 0; i < 10; ++i) CHECK_EQUAL(value(i), v[i]);
+}
+
+TEST(small_vector_emplace_back_own_element) {
+  small_vector<std::string, 2> v;
+  v.emplace_back(value(0));
+  v.emplace_back(value(1));
+
+  // The vector is full, so this grows the storage while the argument refers to an element.
+  v.emplace_back(v[0]);
+  REQUIRE CHECK_EQUAL(3u, v.size());
+  CHECK_EQUAL(value(0), v[0]);
+  CHECK_EQUAL(value(1), v[1]);
+  CHECK_EQUAL(value(0), v[2]);
+
+  v.emplace_back(v[2]);
+  CHECK_EQUAL(value(0), v[3]);
+}
+
+TEST(small_vector_emplace_own_element) {
+  small_vector<std::string, 2> v;
+  v.emplace_back(value(0));
+  v.emplace_back(value(1));
+
+  v.emplace(v.begin(), v[1]);
+  REQUIRE CHECK_EQUAL(3u, v.size());
+  CHECK_EQUAL(value(1), v[0]);
+  CHECK_EQUAL(value(0), v[1]);
+  CHECK_EQUAL(value(1), v[2]);
+}
+
+TEST(small_vector_copy_and_move) {
+  small_vector<std::string, 2> v;
+  for (int i = 0; i < 3; ++i) v.emplace_back(value(i));
+
+  small_vector<std::string, 2> copy(v);
+  small_vector<std::string, 2> moved(std::move(v));
+  CHECK(v.empty());
+  REQUIRE CHECK_EQUAL(3u, copy.size());
+  REQUIRE CHECK_EQUAL(3u, moved.size());
+  for (int i = 0; i < 3; ++i) {
+    CHECK_EQUAL(value(i), copy[i]);
+    CHECK_EQUAL(value(i), moved[i]);
+  }
+}
+
+int main() {
+  return UnitTest::RunAllTests();
+}
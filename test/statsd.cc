@@ -0,0 +1,311 @@
+#include <instrumentation/statsd.h>
+#include <instrumentation/engine.h>
+#include <instrumentation/counter.h>
+#include <instrumentation/counter_u64.h>
+#include <instrumentation/gauge.h>
+#include <instrumentation/gauge_i64.h>
+#include <instrumentation/string.h>
+#include <instrumentation/summary.h>
+#include <instrumentation/timing.h>
+#include <UnitTest++/UnitTest++.h>
+#include "print.h"
+#include "test_collector.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace instrumentation;
+
+namespace {
+
+
+// Datagram socket, standing in for a statsd server.
+class listener {
+  public:
+  // Listen on a free UDP port on the loopback address.
+  listener()
+  : fd_(::socket(AF_INET, SOCK_DGRAM, 0))
+  {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrlen = sizeof(addr);
+    if (::bind(fd_, reinterpret_cast<const sockaddr*>(&addr), addrlen) == -1)
+      throw std::runtime_error("bind failed");
+    if (::getsockname(fd_, reinterpret_cast<sockaddr*>(&addr), &addrlen) == -1)
+      throw std::runtime_error("getsockname failed");
+    port_ = ntohs(addr.sin_port);
+  }
+
+  // Listen on a unix domain socket.
+  explicit listener(const std::string& path)
+  : fd_(::socket(AF_UNIX, SOCK_DGRAM, 0)),
+    path_(path)
+  {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.data(), path.size());
+    ::unlink(path.c_str());
+    if (::bind(fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == -1)
+      throw std::runtime_error("bind failed");
+  }
+
+  listener(const listener&) = delete;
+
+  ~listener() {
+    ::close(fd_);
+    if (!path_.empty()) ::unlink(path_.c_str());
+  }
+
+  auto port() const noexcept -> std::uint16_t { return port_; }
+
+  // Datagrams that have arrived.
+  // Flushes send on the flushing thread, so after a flush, its datagrams have arrived.
+  auto datagrams() -> std::vector<std::string> {
+    std::vector<std::string> result;
+    for (;;) {
+      char buf[65536];
+      const auto rlen = ::recv(fd_, buf, sizeof(buf), MSG_DONTWAIT);
+      if (rlen < 0) return result;
+      result.emplace_back(buf, rlen);
+    }
+  }
+
+  // Lines in the datagrams that have arrived, sorted.
+  auto lines() -> std::vector<std::string> {
+    std::vector<std::string> result;
+    for (std::string_view d : datagrams()) {
+      for (auto eol = d.find('\n'); eol != std::string_view::npos; eol = d.find('\n')) {
+        result.emplace_back(d.substr(0, eol));
+        d.remove_prefix(eol + 1u);
+      }
+      result.emplace_back(d);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+  }
+
+  private:
+  int fd_;
+  std::uint16_t port_ = 0;
+  std::string path_;
+};
+
+// Options that leave flushing to the test.
+auto manual_options() -> statsd_options {
+  statsd_options opts;
+  opts.interval = std::chrono::hours(1);
+  return opts;
+}
+
+
+} /* namespace <unnamed> */
+
+TEST(statsd_counter_deltas) {
+  engine e;
+  counter_vector<std::string> mv(e, "test.requests", {"path"}, "requests");
+  counter_u64_vector<> mv_u64(e, "test.bytes", {}, "bytes");
+  mv.labels("/a") += 5;
+  mv_u64.labels() += 1000u;
+
+  listener l;
+  auto exporter = statsd_exporter::udp(e, "127.0.0.1", l.port(), manual_options());
+
+  exporter.flush();
+  CHECK_EQUAL(
+      std::vector<std::string>({ "test.bytes:1000|c", "test.requests:5|c|#path:/a" }),
+      l.lines());
+
+  mv.labels("/a") += 3;
+  exporter.flush();
+  CHECK_EQUAL(std::vector<std::string>({ "test.requests:3|c|#path:/a" }), l.lines());
+
+  // Nothing changed, so nothing is sent.
+  exporter.flush();
+  CHECK_EQUAL(std::vector<std::string>(), l.lines());
+  CHECK_EQUAL(0u, exporter.dropped());
+}
+
+TEST(statsd_gauges) {
+  engine e;
+  gauge_vector<> g(e, "test.temperature", {}, "temperature");
+  gauge_i64_vector<int> gi(e, "test.depth", {"queue"}, "depth");
+  string_vector<> s(e, "test.version", {}, "version");
+  g.labels() = 21.5;
+  gi.labels(1) = -4;
+  s.labels() = "1.0";
+
+  listener l;
+  auto exporter = statsd_exporter::udp(e, "127.0.0.1", l.port(), manual_options());
+
+  exporter.flush();
+  const auto datagrams = l.datagrams();
+  CHECK_EQUAL(1u, datagrams.size());
+  // A negative gauge is sent as a reset, followed by the adjustment.
+  CHECK(datagrams.at(0).find("test.depth:0|g|#queue:1\ntest.depth:-4|g|#queue:1") != std::string::npos);
+  CHECK(datagrams.at(0).find("test.temperature:21.5|g") != std::string::npos);
+  CHECK(datagrams.at(0).find("test.version") == std::string::npos);
+}
+
+TEST(statsd_timing_and_summary) {
+  using namespace std::chrono_literals;
+
+  engine e;
+  timing_vector<> t(e, "test.latency", {}, {1ms, 10ms}, "latency");
+  summary_vector<> sm(e, "test.size", {}, {0.5}, 0.01, "size");
+  t.labels() << 2ms << 3ms << 20ms;
+  sm.labels() << 5ms;
+
+  listener l;
+  auto exporter = statsd_exporter::udp(e, "127.0.0.1", l.port(), manual_options());
+
+  exporter.flush();
+  const auto lines = l.lines();
+  CHECK(std::count(lines.begin(), lines.end(), "test.latency.bucket:2|c|#le:0.01") == 1);
+  CHECK(std::count(lines.begin(), lines.end(), "test.latency.bucket:1|c|#le:+Inf") == 1);
+  CHECK(std::count(lines.begin(), lines.end(), "test.latency.count:3|c") == 1);
+  CHECK(std::count(lines.begin(), lines.end(), "test.size.count:1|c") == 1);
+  CHECK(std::count(lines.begin(), lines.end(), "test.size.sum:0.005|c") == 1);
+  CHECK(std::count_if(lines.begin(), lines.end(), [](const std::string& line) { return line.find("test.size:") == 0u; }) == 1);
+  // Empty buckets are not sent.
+  CHECK(std::count(lines.begin(), lines.end(), "test.latency.bucket:0|c|#le:0.001") == 0);
+
+  t.labels() << 2ms;
+  exporter.flush();
+  const auto next = l.lines();
+  CHECK(std::count(next.begin(), next.end(), "test.latency.bucket:1|c|#le:0.01") == 1);
+  CHECK(std::count(next.begin(), next.end(), "test.latency.count:1|c") == 1);
+}
+
+TEST(statsd_packs_datagrams) {
+  engine e;
+  counter_vector<int> mv(e, "test.requests", {"idx"}, "requests");
+  for (int i = 0; i < 1000; ++i) mv.labels(i) += 1;
+
+  listener l;
+  statsd_options opts = manual_options();
+  opts.prefix = "app.";
+  opts.max_datagram = 512;
+  auto exporter = statsd_exporter::udp(e, "127.0.0.1", l.port(), opts);
+
+  exporter.flush();
+  const auto datagrams = l.datagrams();
+  std::size_t lines = 0;
+  for (const std::string& d : datagrams) {
+    CHECK(d.size() <= 512u);
+    // Each datagram is filled, so the next line wouldn't have fitted.
+    CHECK(d.size() + sizeof("\napp.test.requests:1|c|#idx:999") > 512u || &d == &datagrams.back());
+    lines += std::count(d.begin(), d.end(), '\n') + 1u;
+    CHECK_EQUAL("app.test.requests:1|c|#idx:", d.substr(0, 27));
+  }
+  CHECK_EQUAL(1000u, lines);
+  CHECK(datagrams.size() < 100u);
+}
+
+TEST(statsd_forgets_expired_counters) {
+  engine e;
+  counter_vector<std::string> mv(e, "test.requests", {"path"}, "requests");
+  mv.expire(expiry::after_scrapes(1));
+  mv.labels("/a") += 1;
+  mv.labels("/b") += 1;
+
+  listener l;
+  statsd_options opts = manual_options();
+  opts.full_flush_interval = 2;
+  auto exporter = statsd_exporter::udp(e, "127.0.0.1", l.port(), opts);
+
+  exporter.flush();
+  CHECK_EQUAL(2u, exporter.counters());
+  l.lines();
+
+  // Two scrapes expire both series, after which one is recreated.
+  test_collector first(e);
+  test_collector second(e);
+  CHECK_EQUAL(2u, mv.expired());
+  mv.labels("/a") += 1;
+
+  // An incremental flush only visits the recreated series.
+  exporter.flush();
+  CHECK_EQUAL(2u, exporter.counters());
+  l.lines();
+
+  // A full flush forgets the counter that no longer exists,
+  // and doesn't send counters that were not modified.
+  exporter.flush();
+  CHECK_EQUAL(1u, exporter.counters());
+  CHECK_EQUAL(std::vector<std::string>(), l.lines());
+}
+
+TEST(statsd_sanitizes) {
+  engine e;
+  counter_vector<std::string> mv(e, "test.requests", {"path"}, "requests");
+  mv.labels("a:b|c,d#e@f") += 1;
+
+  listener l;
+  auto exporter = statsd_exporter::udp(e, "127.0.0.1", l.port(), manual_options());
+
+  exporter.flush();
+  CHECK_EQUAL(std::vector<std::string>({ "test.requests:1|c|#path:a_b_c_d_e_f" }), l.lines());
+}
+
+TEST(statsd_unix_socket_and_final_flush) {
+  engine e;
+  counter_vector<> mv(e, "test.requests", {}, "requests");
+  mv.labels() += 2;
+
+  const std::string path = "test_statsd_" + std::to_string(::getpid()) + ".sock";
+  listener l(path);
+  {
+    auto exporter = statsd_exporter::unix_socket(e, path, manual_options());
+    exporter.flush();
+    CHECK_EQUAL(std::vector<std::string>({ "test.requests:2|c" }), l.lines());
+
+    mv.labels() += 1;
+  }
+
+  // Destroying the exporter flushes what changed since the previous flush.
+  CHECK_EQUAL(std::vector<std::string>({ "test.requests:1|c" }), l.lines());
+}
+
+TEST(statsd_interval) {
+  engine e;
+  counter_vector<> mv(e, "test.requests", {}, "requests");
+  mv.labels() += 2;
+
+  listener l;
+  statsd_options opts;
+  opts.interval = std::chrono::milliseconds(10);
+  auto exporter = statsd_exporter::udp(e, "127.0.0.1", l.port(), opts);
+
+  std::vector<std::string> lines;
+  for (int i = 0; i < 500 && lines.empty(); ++i) {
+    ::usleep(10000);
+    lines = l.lines();
+  }
+  CHECK_EQUAL(std::vector<std::string>({ "test.requests:2|c" }), lines);
+}
+
+TEST(statsd_invalid_options) {
+  engine e;
+  statsd_options opts;
+  opts.interval = std::chrono::milliseconds(0);
+  CHECK_THROW(statsd_exporter::udp(e, "127.0.0.1", 8125, opts), std::logic_error);
+  opts = statsd_options();
+  opts.full_flush_interval = 0;
+  CHECK_THROW(statsd_exporter::udp(e, "127.0.0.1", 8125, opts), std::logic_error);
+  CHECK_THROW(statsd_exporter::udp(e, "localhost", 8125), std::invalid_argument);
+}
+
+int main() {
+  return UnitTest::RunAllTests();
+}
@@ -0,0 +1,107 @@
+#include <instrumentation/summary.h>
+#include <instrumentation/engine.h>
+#include <UnitTest++/UnitTest++.h>
+#include "test_collector.h"
+#include "print.h"
+#include <chrono>
+#include <cmath>
+#include <string>
+
+using namespace instrumentation;
+using namespace std::chrono_literals;
+
+TEST(default_constructor_creates_no_metric) {
+  summary_vector<> sv;
+  summary s = sv.labels();
+
+  CHECK_EQUAL(true, !sv);
+  CHECK_EQUAL(false, bool(sv));
+
+  CHECK_EQUAL(true, !s);
+  CHECK_EQUAL(false, bool(s));
+
+  CHECK(std::get<0>(*s).empty());
+  CHECK_EQUAL(0u, std::get<1>(*s));
+}
+
+TEST(no_metric_summary_ops_have_no_effect) {
+  summary s;
+
+  s << 1ms << 5s;
+  CHECK(std::get<0>(*s).empty());
+  CHECK_EQUAL(0u, std::get<1>(*s));
+}
+
+TEST(empty_summary) {
+  engine e;
+  summary s = summary_vector<>(e, "test.metric", {}, {0.5, 0.9}, 0.01, "").labels();
+
+  CHECK_EQUAL(
+      std::vector<summary::quantile_entry>({
+            { 0.5, 0s },
+            { 0.9, 0s },
+          }),
+      std::get<0>(*s));
+  CHECK_EQUAL(0u, std::get<1>(*s));
+  CHECK_EQUAL(0, std::get<2>(*s).count());
+}
+
+TEST(summary_quantiles_within_relative_accuracy) {
+  engine e;
+  summary s = summary_vector<>(e, "test.metric", {}, {0.0, 0.5, 0.9, 0.99, 1.0}, 0.01, "").labels();
+
+  for (int i = 1; i <= 1000; ++i) s << std::chrono::milliseconds(i);
+
+  const auto [quantiles, count, sum] = *s;
+  CHECK_EQUAL(1000u, count);
+  CHECK_EQUAL(500500, std::chrono::duration_cast<std::chrono::milliseconds>(sum).count());
+
+  const double expected[] = { 1.0, 500.0, 900.0, 990.0, 1000.0 };
+  REQUIRE CHECK_EQUAL(5u, quantiles.size());
+  for (std::size_t i = 0; i < quantiles.size(); ++i) {
+    const double actual = std::chrono::duration<double, std::milli>(quantiles[i].value).count();
+    CHECK_CLOSE(expected[i], actual, expected[i] * 0.01);
+  }
+}
+
+TEST(summary_quantile_of_wide_range) {
+  engine e;
+  summary s = summary_vector<>(e, "test.metric", {}).labels();
+
+  s << 1ns << 1us << 1ms << 1s << 1000s;
+
+  const std::chrono::duration<double, std::nano> q0 = s.quantile(0.0);
+  const std::chrono::duration<double, std::milli> q50 = s.quantile(0.5);
+  const std::chrono::duration<double> q100 = s.quantile(1.0);
+  CHECK_CLOSE(1.0, q0.count(), 0.01);
+  CHECK_CLOSE(1.0, q50.count(), 0.01);
+  CHECK_CLOSE(1000.0, q100.count(), 10.0);
+}
+
+TEST(summary_zero_durations) {
+  engine e;
+  summary s = summary_vector<>(e, "test.metric", {}).labels();
+
+  s << 0s << 0s << 1s;
+
+  CHECK_EQUAL(0, s.quantile(0.5).count());
+  CHECK_CLOSE(1.0, std::chrono::duration<double>(s.quantile(1.0)).count(), 0.01);
+}
+
+TEST(summary_vector) {
+  engine e;
+  summary_vector<std::string> sv(e, "test.metric", {"label_name"}, {0.5}, 0.01, "this is a test");
+
+  sv.labels("foo") << 0s;
+
+  CHECK_EQUAL(
+      test_collector(
+          { {"test.metric", "this is a test"} },
+          { {"test.metric{label_name=\"foo\"}", "[" + std::to_string(0.5) + "==>" + std::to_string(0.0) + ", count==>1, sum==>" + std::to_string(0.0) + "]"},
+          }),
+      test_collector(e));
+}
+
+int main() {
+  return UnitTest::RunAllTests();
+}
@@ -0,0 +1,112 @@
+#include <instrumentation/tags.h>
+#include <UnitTest++/UnitTest++.h>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+using namespace instrumentation;
+
+namespace {
+
+auto names(const tags& t) -> std::vector<std::string> {
+  std::vector<std::string> result;
+  for (const auto& e : t) result.push_back(e.first);
+  return result;
+}
+
+} /* namespace <unnamed> */
+
+TEST(empty_tags) {
+  const tags t;
+
+  CHECK_EQUAL(true, t.empty());
+  CHECK_EQUAL(0u, t.size());
+  CHECK(t.begin() == t.end());
+  CHECK(t.find("x") == nullptr);
+}
+
+TEST(tags_are_sorted) {
+  tags t;
+  t.with("c", 3).with("a", 1.5).with("b", true).with("d", "four");
+
+  CHECK(names(t) == std::vector<std::string>({ "a", "b", "c", "d" }));
+  CHECK(*t.find("a") == tags::tag_value(1.5));
+  CHECK(*t.find("b") == tags::tag_value(true));
+  CHECK(*t.find("c") == tags::tag_value(std::int64_t(3)));
+  CHECK(*t.find("d") == tags::tag_value(std::string("four")));
+  CHECK_EQUAL(1u, t.count("d"));
+  CHECK_EQUAL(0u, t.count("e"));
+}
+
+TEST(tags_with_replaces) {
+  tags t;
+  t.with("a", 1).with("a", "one");
+
+  CHECK_EQUAL(1u, t.size());
+  CHECK(*t.find("a") == tags::tag_value(std::string("one")));
+}
+
+TEST(tags_initializer_list) {
+  const tags t{ {"b", std::int64_t(2)}, {"a", true}, {"b", 3.0} };
+
+  CHECK(names(t) == std::vector<std::string>({ "a", "b" }));
+  CHECK(*t.find("b") == tags::tag_value(std::int64_t(2)));
+}
+
+TEST(tags_beyond_inline_size) {
+  tags t;
+  for (int i = 9; i >= 0; --i) t.with("tag" + std::to_string(i), i);
+  CHECK_EQUAL(10u, t.size());
+
+  const tags copy = t;
+  tags moved = std::move(t);
+  CHECK(names(copy) == names(moved));
+  CHECK_EQUAL("tag0", copy.begin()->first);
+  CHECK(*moved.find("tag7") == tags::tag_value(std::int64_t(7)));
+
+  tags small;
+  small.with("x", 1);
+  small = copy;
+  CHECK(names(small) == names(copy));
+  moved = tags().with("y", 2);
+  CHECK(names(moved) == std::vector<std::string>({ "y" }));
+}
+
+TEST(tags_modification_drops_fragment) {
+  tags t;
+  t.with("a", 1);
+  t.render();
+  REQUIRE CHECK(t.fragment() != nullptr);
+  CHECK_EQUAL("a=\"1\",", t.fragment()->text());
+
+  t.with("b", 2);
+  CHECK(t.fragment() == nullptr);
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+TEST(tags_deprecated_data) {
+  const tags t = tags().with("b", 2).with("a", "x");
+
+  const auto d = t.data();
+  CHECK_EQUAL(2u, d.size());
+  CHECK(!d.empty());
+  std::vector<std::string> data_names;
+  for (const auto& e : d) data_names.push_back(e.first);
+  CHECK_EQUAL(names(t).size(), data_names.size());
+  CHECK(names(t) == data_names);
+
+  REQUIRE CHECK(d.find("b") != d.end());
+  CHECK(std::get<std::int64_t>(d.find("b")->second) == 2);
+  CHECK(d.find("c") == d.end());
+  CHECK_EQUAL(1u, d.count("a"));
+  CHECK(std::get<std::string>(d.at("a")) == "x");
+  CHECK_THROW(d.at("c"), std::out_of_range);
+}
+#pragma GCC diagnostic pop
+
+int main() {
+  return UnitTest::RunAllTests();
+}
@@ -1,7 +1,10 @@
 #include "test_collector.h"
 #include <instrumentation/counter.h>
+#include <instrumentation/counter_u64.h>
 #include <instrumentation/gauge.h>
+#include <instrumentation/gauge_i64.h>
 #include <instrumentation/string.h>
+#include <instrumentation/summary.h>
 #include <instrumentation/timing.h>
 #include <ostream>
 
@@ -15,10 +18,18 @@ void test_collector::visit(const instrumentation::metric_name& n, const instrume
   metrics.emplace(to_string_(n) + to_string_(t), val_to_string_(*m));
 }
 
+void test_collector::visit(const instrumentation::metric_name& n, const instrumentation::tags& t, const instrumentation::counter_u64& m) {
+  metrics.emplace(to_string_(n) + to_string_(t), val_to_string_(*m));
+}
+
 void test_collector::visit(const instrumentation::metric_name& n, const instrumentation::tags& t, const instrumentation::gauge& m) {
   metrics.emplace(to_string_(n) + to_string_(t), val_to_string_(*m));
 }
 
+void test_collector::visit(const instrumentation::metric_name& n, const instrumentation::tags& t, const instrumentation::gauge_i64& m) {
+  metrics.emplace(to_string_(n) + to_string_(t), val_to_string_(*m));
+}
+
 void test_collector::visit(const instrumentation::metric_name& n, const instrumentation::tags& t, const instrumentation::string& m) {
   metrics.emplace(to_string_(n) + to_string_(t), val_to_string_(*m));
 }
@@ -27,13 +38,17 @@ void test_collector::visit(const instrumentation::metric_name& n, const instrume
   metrics.emplace(to_string_(n) + to_string_(t), val_to_string_(*m));
 }
 
+void test_collector::visit(const instrumentation::metric_name& n, const instrumentation::tags& t, const instrumentation::summary& m) {
+  metrics.emplace(to_string_(n) + to_string_(t), val_to_string_(*m));
+}
+
 auto test_collector::to_string_(const instrumentation::metric_name& m) -> std::string {
   return m.with_separator();
 }
 
 auto test_collector::to_string_(const instrumentation::tags& t) -> std::string {
   std::map<std::string, std::string> labels;
-  for (const auto& tval : t.data()) {
+  for (const auto& tval : t) {
     labels[tval.first] = std::visit(
         [](const auto& v) {
           return val_to_string_(v);
@@ -92,6 +107,24 @@ auto test_collector::val_to_string_(const std::tuple<std::vector<instrumentation
   return out;
 }
 
+auto test_collector::val_to_string_(const std::tuple<std::vector<instrumentation::summary::quantile_entry>, std::uint64_t, instrumentation::summary::duration>& s) -> std::string {
+  std::string out = "[";
+  for (const auto& q_entry : std::get<0>(s)) {
+    std::chrono::duration<double> seconds = q_entry.value;
+    out += val_to_string_(q_entry.quantile);
+    out += "==>";
+    out += val_to_string_(seconds.count());
+    out += ", ";
+  }
+  std::chrono::duration<double> sum = std::get<2>(s);
+  out += "count==>";
+  out += val_to_string_(std::get<1>(s));
+  out += ", sum==>";
+  out += val_to_string_(sum.count());
+  out += "]";
+  return out;
+}
+
 auto operator<<(std::ostream& out, const test_collector& tc) -> std::ostream& {
   out << "{\n";
 
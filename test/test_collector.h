@@ -4,6 +4,7 @@
 #include <instrumentation/collector.h>
 #include <instrumentation/metric_name.h>
 #include <instrumentation/tags.h>
+#include <instrumentation/summary.h>
 #include <instrumentation/timing.h>
 #include <map>
 #include <string>
@@ -33,9 +34,12 @@ class test_collector final
 
   void visit_description(const instrumentation::metric_name& n, std::string_view description) override;
   void visit(const instrumentation::metric_name& n, const instrumentation::tags& t, const instrumentation::counter& m) override;
+  void visit(const instrumentation::metric_name& n, const instrumentation::tags& t, const instrumentation::counter_u64& m) override;
   void visit(const instrumentation::metric_name& n, const instrumentation::tags& t, const instrumentation::gauge& m) override;
+  void visit(const instrumentation::metric_name& n, const instrumentation::tags& t, const instrumentation::gauge_i64& m) override;
   void visit(const instrumentation::metric_name& n, const instrumentation::tags& t, const instrumentation::string& m) override;
   void visit(const instrumentation::metric_name& n, const instrumentation::tags& t, const instrumentation::timing& m) override;
+  void visit(const instrumentation::metric_name& n, const instrumentation::tags& t, const instrumentation::summary& m) override;
 
   private:
   static auto to_string_(const instrumentation::metric_name& m) -> std::string;
@@ -47,6 +51,7 @@ class test_collector final
   static auto val_to_string_(double v) -> std::string;
   static auto val_to_string_(const std::string& v) -> std::string;
   static auto val_to_string_(const std::tuple<std::vector<instrumentation::timing::histogram_entry>, std::uint64_t>& h) -> std::string;
+  static auto val_to_string_(const std::tuple<std::vector<instrumentation::summary::quantile_entry>, std::uint64_t, instrumentation::summary::duration>& s) -> std::string;
 
   public:
   std::multimap<std::string, std::string> descriptions;
@@ -4,6 +4,8 @@
 #include "test_collector.h"
 #include "print.h"
 #include <string>
+#include <thread>
+#include <vector>
 
 using namespace instrumentation;
 using namespace std::chrono_literals;
@@ -55,6 +57,89 @@ TEST(timing_ops) {
   REQUIRE CHECK_EQUAL(1u, std::get<1>(*t)); // 6s
 }
 
+TEST(padded_timing_ops) {
+  engine e;
+  timing t = timing_vector<>(e, "test.metric", {}, {3s, 5s}, timing_layout::padded, "").labels();
+
+  REQUIRE CHECK_EQUAL(
+      std::vector<timing::histogram_entry>({
+            { 3s, 0 },
+            { 5s, 0 },
+          }),
+      std::get<0>(*t));
+  REQUIRE CHECK_EQUAL(0u, std::get<1>(*t));
+
+  t << 1s << 2s << 3s << 4s << 5s << 6s;
+  REQUIRE CHECK_EQUAL(
+      std::vector<timing::histogram_entry>({
+            { 3s, 3 }, // 1s, 2s, 3s
+            { 5s, 2 }, // 4s, 5s
+          }),
+      std::get<0>(*t));
+  REQUIRE CHECK_EQUAL(1u, std::get<1>(*t)); // 6s
+}
+
+TEST(sharded_timing_sums_all_threads) {
+  engine e;
+  timing t = timing_vector<>(e, "test.metric", {}, {3s, 5s}, timing_layout::sharded, "").labels();
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back(
+        [t]() {
+          for (int j = 0; j < 1000; ++j) t << 1s << 4s << 6s;
+        });
+  }
+  for (auto& thr : threads) thr.join();
+
+  CHECK_EQUAL(
+      std::vector<timing::histogram_entry>({
+            { 3s, 8000 },
+            { 5s, 8000 },
+          }),
+      std::get<0>(*t));
+  CHECK_EQUAL(8000u, std::get<1>(*t));
+}
+
+TEST(log_linear_thresholds) {
+  engine e;
+  timing t = timing_vector<>(e, "test.metric", {}, log_linear_buckets{ 1ns, 8ns, 1 }, "").labels();
+
+  CHECK_EQUAL(
+      std::vector<timing::histogram_entry>({
+            { 1ns, 0 },
+            { 2ns, 0 },
+            { 3ns, 0 },
+            { 4ns, 0 },
+            { 6ns, 0 },
+            { 8ns, 0 },
+          }),
+      std::get<0>(*t));
+}
+
+TEST(log_linear_matches_threshold_search) {
+  engine e;
+  timing ll = timing_vector<>(e, "test.log_linear", {}, log_linear_buckets{ 1us, 10s, 3 }, "").labels();
+  const auto ll_histogram = *ll;
+  std::vector<timing::duration> thresholds;
+  for (const auto& he : std::get<0>(ll_histogram)) thresholds.push_back(he.le);
+  timing searched = timing_vector<>(e, "test.searched", {}, thresholds, "").labels();
+
+  std::vector<timing::duration> samples{ 0ns, -5ns, 100s };
+  for (const auto& threshold : thresholds) {
+    samples.push_back(threshold - 1ns);
+    samples.push_back(threshold);
+    samples.push_back(threshold + 1ns);
+  }
+  for (const auto& d : samples) {
+    ll << d;
+    searched << d;
+  }
+
+  CHECK_EQUAL(std::get<0>(*searched), std::get<0>(*ll));
+  CHECK_EQUAL(std::get<1>(*searched), std::get<1>(*ll));
+}
+
 TEST(timing_vector) {
   engine e;
   timing_vector<std::string> tv(e, "test.metric", {"label_name"}, {3s, 5s}, "this is a test");